@@ -0,0 +1,239 @@
+/* Distance-to-mate analysis of the engines
+Author: Phillip Stewart
+
+Answers "how far from optimal is our play?" over the whole position space:
+	every legal board with X to move (all 64^3, no symmetry shortcut) is
+	played out with stripped_test_play() and the number of X moves is
+	compared with the true distance to mate from the tablebase (tb_dtm()).
+	excess = moves played - DTM, so 0 is perfect play.
+	Games that do not end in mate (rook taken, stalemate, or still going
+	after ANALYSIS_TURNS) count as worse than any mate.
+Boards the tablebase calls a draw (Y takes the rook at once) are skipped.
+
+Printed: a histogram of the excess, and a table by DTM of the mean and
+	worst number of moves played.
+Written to the output file: the ANALYSIS_TOP_N worst positions, worst first,
+	one per line as "<board>\t<played>\t<dtm>\t<result>". The board comes
+	first in the test case format, so the file can be given back to
+	main_find to replay those positions.
+
+The work is split into one task per (K, R) pair like the finder, and the
+	boards are generated as each task runs, so nothing grows with the
+	number of positions: each worker keeps its own totals and a bounded
+	heap of its worst offenders, and both are merged at the end.
+*/
+
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "helper.h"
+#include "engine.h"
+#include "play.h"
+#include "tablebase.h"
+#include "transposition.h"
+#include "analysis.h"
+using namespace std;
+
+
+void analysis_worker(atomic<int>* next_task, const EngineConfig* cfg,
+	AnalysisTotals* totals, vector<offender>* worst);
+bool offender_ranks_higher(const offender& a, const offender& b);
+void print_analysis(const AnalysisTotals& totals);
+void save_offenders(string filename, const vector<offender>& worst);
+
+
+/* Plays cfg from every legal board and reports against the DTM
+Input:	cfg - the engines to analyze
+		filename - where the worst positions are written
+*/
+void run_analysis(const EngineConfig& cfg, string filename) {
+	atomic<int> next_task(0);
+	int num_threads = thread::hardware_concurrency();
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	vector<AnalysisTotals> totals(num_threads, AnalysisTotals());
+	vector< vector<offender> > worst(num_threads);
+	vector<thread> workers;
+	for (int t=0; t < num_threads; t++) {
+		workers.push_back(thread(analysis_worker, &next_task, &cfg, &totals[t], &worst[t]));
+	}
+	AnalysisTotals total = AnalysisTotals();
+	vector<offender> merged;
+	for (int t=0; t < num_threads; t++) {
+		workers[t].join();
+		total.positions += totals[t].positions;
+		total.tb_draws += totals[t].tb_draws;
+		for (int d=0; d < ANALYSIS_MAX_DTM; d++) {
+			for (int p=0; p <= ANALYSIS_TURNS + 1; p++) {
+				total.played[d][p] += totals[t].played[d][p];
+			}
+		}
+		merged.insert(merged.end(), worst[t].begin(), worst[t].end());
+	}
+	sort(merged.begin(), merged.end(), offender_ranks_higher);
+	if (merged.size() > ANALYSIS_TOP_N) {
+		merged.resize(ANALYSIS_TOP_N);
+	}
+
+	cout << "X: " << cfg.x->name << ", Y: " << cfg.y->name << ", depth " << cfg.depth << endl;
+	print_analysis(total);
+	save_offenders(filename, merged);
+	cout << "Worst " << merged.size() << " positions written to " << filename << endl;
+}
+
+
+/* Worker thread for run_analysis
+Input:	next_task - shared counter of the next (K, R) pair to play
+		cfg - the engines to analyze
+		totals - filled with this worker's counts when done
+		worst - filled with this worker's worst ANALYSIS_TOP_N when done
+*/
+void analysis_worker(atomic<int>* next_task, const EngineConfig* cfg,
+	AnalysisTotals* totals, vector<offender>* worst) {
+	priority_queue<offender, vector<offender>, bool(*)(const offender&, const offender&)> heap(offender_ranks_higher);
+	TransTable tt;
+	GameRecord record;
+	offender o;
+	state s;
+	int task;
+	while ((task = (*next_task)++) < 64*64) {
+		for (int k=0; k < 64; k++) {
+			s = state(task / 64, task % 64, k);
+			if (!s.is_valid() || kings_too_close(s) || y_in_check(s)) {
+				continue;
+			}
+			o.dtm = tb_dtm(s, true);
+			if (o.dtm == TB_DRAW) {
+				totals->tb_draws++;
+				continue;
+			}
+			o.played = stripped_test_play(s, ANALYSIS_TURNS, &tt, *cfg, &record);
+			o.outcome = record.outcome;
+			totals->positions++;
+			if (o.outcome == GAME_MATE) {
+				o.excess = o.played - o.dtm;
+				totals->played[o.dtm][o.played]++;
+			} else {
+				//ranks below every mate
+				o.excess = ANALYSIS_TURNS + 1;
+				totals->played[o.dtm][ANALYSIS_TURNS + 1]++;
+			}
+			o.order = task*64 + k;
+			o.s = s;
+			//heap.top() is the least bad position kept so far.
+			if ((int)heap.size() < ANALYSIS_TOP_N) {
+				heap.push(o);
+			} else if (offender_ranks_higher(o, heap.top())) {
+				heap.pop();
+				heap.push(o);
+			}
+		}
+	}
+	while (!heap.empty()) {
+		worst->push_back(heap.top());
+		heap.pop();
+	}
+}
+
+
+/* Ordering for the offenders: larger excess first, ties go to the
+	earlier board, so the output does not depend on thread scheduling.
+*/
+bool offender_ranks_higher(const offender& a, const offender& b) {
+	if (a.excess != b.excess) {
+		return a.excess > b.excess;
+	}
+	return a.order < b.order;
+}
+
+
+/* Prints the excess histogram and the table by DTM */
+void print_analysis(const AnalysisTotals& totals) {
+	//excess runs from -ANALYSIS_MAX_DTM (Y blundered into mate) up to
+	//	ANALYSIS_TURNS, and the last slot is for games with no mate.
+	vector<long> excess(ANALYSIS_MAX_DTM + ANALYSIS_TURNS + 2, 0);
+	long no_mate = 0;
+	double excess_sum = 0.0;
+	for (int d=0; d < ANALYSIS_MAX_DTM; d++) {
+		for (int p=0; p <= ANALYSIS_TURNS; p++) {
+			excess[p - d + ANALYSIS_MAX_DTM] += totals.played[d][p];
+			excess_sum += (double)(p - d) * totals.played[d][p];
+		}
+		no_mate += totals.played[d][ANALYSIS_TURNS + 1];
+	}
+	long mates = totals.positions - no_mate;
+	long positions = totals.positions > 0 ? totals.positions : 1;
+
+	cout << "Positions: " << totals.positions << " (" << totals.tb_draws
+		<< " tablebase draws skipped)\n";
+	//restored at the end, so later output is not changed.
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	cout << fixed << setprecision(2);
+	cout << "Optimal: " << 100.0 * excess[ANALYSIS_MAX_DTM] / positions << "%";
+	if (mates > 0) {
+		cout << ", mean excess " << excess_sum / mates << " moves";
+	}
+	cout << endl;
+	cout << "--------------------------------------\n";
+	cout << "Excess      Count        %\n";
+	for (int i=0; i < (int)excess.size(); i++) {
+		if (excess[i] == 0) {
+			continue;
+		}
+		cout << setw(6) << i - ANALYSIS_MAX_DTM << setw(11) << excess[i]
+			<< setw(9) << 100.0 * excess[i] / positions << endl;
+	}
+	cout << setw(6) << "none" << setw(11) << no_mate
+		<< setw(9) << 100.0 * no_mate / positions << endl;
+	cout << "--------------------------------------\n";
+	cout << "DTM   Games   Mean played   Worst   No mate\n";
+	for (int d=0; d < ANALYSIS_MAX_DTM; d++) {
+		long games = 0;
+		long played_sum = 0;
+		int worst = 0;
+		for (int p=0; p <= ANALYSIS_TURNS; p++) {
+			games += totals.played[d][p];
+			played_sum += (long)p * totals.played[d][p];
+			if (totals.played[d][p] > 0) {
+				worst = p;
+			}
+		}
+		if (games + totals.played[d][ANALYSIS_TURNS + 1] == 0) {
+			continue;
+		}
+		cout << setw(3) << d << setw(8) << games + totals.played[d][ANALYSIS_TURNS + 1]
+			<< setw(14) << (games ? (double)played_sum / games : 0.0)
+			<< setw(8) << worst << setw(10) << totals.played[d][ANALYSIS_TURNS + 1] << endl;
+	}
+	cout << "--------------------------------------\n";
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
+
+/* Writes the offenders, worst first */
+void save_offenders(string filename, const vector<offender>& worst) {
+	ofstream ofile;
+	ofile.open(filename);
+	if (!ofile) {
+		err("Could not open " + filename + " for writing.");
+	}
+	const char* results[] = {"mate", "stalemate", "rook taken", "unfinished"};
+	for (int i=0; i < (int)worst.size(); i++) {
+		ofile << state_to_string(worst[i].s) << "\t" << worst[i].played << "\t"
+			<< worst[i].dtm << "\t" << results[worst[i].outcome] << "\n";
+	}
+	ofile.close();
+}
+
+
+// end of analysis.cpp
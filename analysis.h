@@ -0,0 +1,34 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <string>
+#include "helper.h"
+#include "engine.h"
+
+#define ANALYSIS_TURNS 35
+#define ANALYSIS_MAX_DTM 32
+#define ANALYSIS_TOP_N 1000
+#define ANALYSIS_FILE "analysis_worst.txt"
+
+/* Game counts by true DTM and X moves actually played
+played[dtm][ANALYSIS_TURNS + 1] counts the games that did not end in mate.
+*/
+struct AnalysisTotals {
+	long positions;
+	long tb_draws;
+	long played[ANALYSIS_MAX_DTM][ANALYSIS_TURNS + 2];
+};
+
+/* A position that took much longer than the DTM (see analysis.cpp) */
+struct offender {
+	int excess;
+	int order;
+	int played;
+	int dtm;
+	int outcome;
+	state s;
+};
+
+void run_analysis(const EngineConfig& cfg, std::string filename);
+
+#endif
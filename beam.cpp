@@ -0,0 +1,222 @@
+/* Beam search engine for player X and player Y
+Author: Phillip Stewart
+
+A general version of the top-k pruning in ex_minimax_moveX() (5 X moves,
+	3 Y replies) and minimax_moveY() (4 Y moves), with the widths and the
+	depth picked at runtime instead of in the code:
+	SearchContext::x_beam - X moves kept at each X node (--beam=<x>,<y>)
+	SearchContext::y_beam - Y replies kept at each Y node
+	SearchContext::depth - replies searched, so 2*depth+1 plies
+Each node keeps its best moves by the mover's heuristic (heuristicX_batch()
+	or heuristicY_batch(), then pick_best()), so the tree has at most
+	(x_beam*y_beam)^depth leaves. The leaves all come after a move by the
+	side searching, and are scored with that side's heuristic; the scores
+	are then backed up as a real minimax (the searching side takes the
+	best child, the other side the worst). Mate, stalemate and a taken
+	rook are scored as such wherever they come up.
+
+The tree is built one ply at a time into a single arena (a vector of
+	beam_node, each pointing at its parent). The arena belongs to the
+	thread and is only cleared between searches, so after the first move
+	searching allocates nothing. Children always come after their parent,
+	so one backward pass over the arena backs up every score.
+If the widths and depth could build more than BEAM_MAX_NODES nodes the
+	depth is lowered until they fit (see beam_search_depth()), which
+	print_beam_depth() in engine.cpp reports on stderr at startup.
+*/
+
+
+#include <vector>
+#include <climits>
+#include "helper.h"
+#include "heuristic.h"
+#include "move.h"
+#include "profile.h"
+#include "beam.h"
+using namespace std;
+
+
+static thread_local vector<beam_node> beam_arena;
+
+
+/* The depth a beam search will really use
+Input:	int depth, x_beam, y_beam - the requested depth and widths
+Output:	int - the largest depth up to depth whose tree fits in BEAM_MAX_NODES
+*/
+int beam_search_depth(int depth, int x_beam, int y_beam) {
+	//the searching side's width comes first, so the bigger one is the worst case.
+	long mine = (x_beam > y_beam) ? x_beam : y_beam;
+	long theirs = (x_beam > y_beam) ? y_beam : x_beam;
+	for (; depth > 0; depth--) {
+		long level = 1;
+		long total = 1;
+		for (int ply=0; ply < 2*depth + 1 && total <= BEAM_MAX_NODES; ply++) {
+			level *= (ply % 2 == 0) ? mine : theirs;
+			total += level;
+		}
+		if (total <= BEAM_MAX_NODES) {
+			break;
+		}
+	}
+	return depth;
+}
+
+
+/* Score of a board where the game is over, for the side searching
+Input:	bool x_root - true if X is searching
+		bool mate - checkmate, otherwise a draw (stalemate or rook taken)
+		int ply - plies from the root, so nearer mates score higher
+*/
+static int beam_terminal_score(bool x_root, bool mate, int ply) {
+	if (x_root) {
+		return mate ? MATE_SCORE - ply : 0;
+	} else {
+		//a draw is as good for Y as taking the rook (see heuristicY_live()).
+		return mate ? ply - MATE_SCORE : 65536;
+	}
+}
+
+
+/* Builds and scores the beam search tree from s (see the top of the file)
+Input:	state s - the board, x_root to move
+		bool x_root - the side searching
+		SearchContext& ctx - widths, depth and node count
+Output:	int - number of root moves, which are beam_arena[1..n] (0 if none)
+*/
+static int beam_search(state s, bool x_root, SearchContext& ctx) {
+	vector<beam_node>& arena = beam_arena;
+	int x_beam = (ctx.x_beam < 1) ? 1 : ctx.x_beam;
+	int y_beam = (ctx.y_beam < 1) ? 1 : ctx.y_beam;
+	int plies = 2*beam_search_depth(ctx.depth, x_beam, y_beam) + 1;
+	arena.clear();
+	beam_node root = {s, -1, 0, 0, 0};
+	arena.push_back(root);
+
+	int level_start = 0;
+	int level_end = 1;
+	int ranks[MAX_MOVES];
+	for (int ply=0; ply < plies; ply++) {
+		bool mine = (ply % 2 == 0);
+		bool x_to_move = (mine == x_root);
+		int width = x_to_move ? x_beam : y_beam;
+		for (int i=level_start; i < level_end; i++) {
+			state node = arena[i].s;
+			MoveList moves;
+			if (x_to_move) {
+				if (node.R == 255) {
+					arena[i].score = beam_terminal_score(x_root, false, ply);
+					continue;
+				}
+				moves = list_all_moves_x(node);
+				if (moves.size() == 0) {
+					arena[i].score = beam_terminal_score(x_root, false, ply);
+					continue;
+				}
+				heuristicX_batch(node, moves, ranks);
+			} else {
+				moves = list_all_moves_y(node);
+				if (moves.size() == 0) {
+					arena[i].score = beam_terminal_score(x_root, y_in_check(node), ply);
+					continue;
+				}
+				heuristicY_batch(node, moves, ranks);
+			}
+			RankedMoves ranked_moves;
+			for (int j=0; j < (int)moves.size(); j++) {
+				ranked_moves.push_back(make_pair(ranks[j], moves[j]));
+			}
+			//the searching side wants the highest score, the other side the lowest.
+			arena[i].score = mine ? INT_MIN : INT_MAX;
+			for (int j=0; j < width && j < (int)ranked_moves.size(); j++) {
+				pair<int, unsigned char> m = ranked_moves.pick_best(j);
+				//the last ply is the searching side's, so its rank is the leaf score.
+				beam_node child = {make_move(node, m.second, x_to_move), i, m.first,
+					m.second, (unsigned char)(ply + 1)};
+				arena.push_back(child);
+			}
+		}
+		level_start = level_end;
+		level_end = arena.size();
+	}
+	//the last move may have ended the game, which the heuristics don't score.
+	for (int i=level_start; i < level_end; i++) {
+		state leaf = arena[i].s;
+		if (x_root && !has_any_legal_move_y(leaf)) {
+			arena[i].score = beam_terminal_score(true, y_in_check(leaf), plies);
+		} else if (!x_root && leaf.R == 255) {
+			arena[i].score = beam_terminal_score(false, false, plies);
+		}
+	}
+
+	for (int i=(int)arena.size() - 1; i > 0; i--) {
+		beam_node& parent = arena[arena[i].parent];
+		if (parent.ply % 2 == 0) {
+			if (arena[i].score > parent.score) {
+				parent.score = arena[i].score;
+			}
+		} else if (arena[i].score < parent.score) {
+			parent.score = arena[i].score;
+		}
+	}
+
+	ctx.nodes += arena.size();
+	if (PROFILE_SEARCH) {
+		search_stats.nodes += arena.size();
+	}
+	int root_moves = 0;
+	while (root_moves + 1 < (int)arena.size() && arena[root_moves + 1].parent == 0) {
+		root_moves++;
+	}
+	return root_moves;
+}
+
+
+/* Beam search move for player X
+Avoids going back to the position from two moves ago, like moveX().
+Input:	state s - current state of the board
+		SearchContext& ctx - widths, depth and this game's memory
+Output:	move as in moveX()
+*/
+unsigned char beam_moveX(state s, SearchContext& ctx) {
+	int n = beam_search(s, true, ctx);
+	if (n == 0) {
+		err("No moves found for X?!?!");
+	}
+	//root moves are in heuristic order, so ties go to the better looking move.
+	int best = -1;
+	for (int i=1; i <= n; i++) {
+		if (n > 1 && beam_arena[i].s.key == ctx.r2) {
+			continue;
+		}
+		if (best < 0 || beam_arena[i].score > beam_arena[best].score) {
+			best = i;
+		}
+	}
+	unsigned char move = beam_arena[best].move;
+	ctx.r2 = ctx.remembered;
+	ctx.remembered = beam_arena[best].s.key;
+	return move;
+}
+
+
+/* Beam search move for player Y
+Input:	state s - current state of the board
+		SearchContext& ctx - widths and depth
+Output:	move as in moveY(), 255 if Y has no move
+*/
+unsigned char beam_moveY(state s, SearchContext& ctx) {
+	int n = beam_search(s, false, ctx);
+	if (n == 0) {
+		return 255;
+	}
+	int best = 1;
+	for (int i=2; i <= n; i++) {
+		if (beam_arena[i].score > beam_arena[best].score) {
+			best = i;
+		}
+	}
+	return beam_arena[best].move;
+}
+
+
+// end of beam.cpp
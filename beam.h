@@ -0,0 +1,22 @@
+#ifndef BEAM_H
+#define BEAM_H
+
+#include "helper.h"
+#include "move.h"
+
+#define BEAM_MAX_NODES (1 << 18)
+
+/* One position in the beam search tree, see beam.cpp */
+struct beam_node {
+	state s;
+	int parent;
+	int score;
+	unsigned char move;
+	unsigned char ply;
+};
+
+unsigned char beam_moveX(state s, SearchContext& ctx);
+unsigned char beam_moveY(state s, SearchContext& ctx);
+int beam_search_depth(int depth, int x_beam, int y_beam);
+
+#endif
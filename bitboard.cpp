@@ -0,0 +1,71 @@
+/* Bitboard tables for move generation
+Author: Phillip Stewart
+
+A bitboard is a 64 bit set with one bit per square, bit n = square n
+	(the same numbering as state, square = file*8 + rank).
+So moving up a rank is a shift by 1, and moving across a file a shift by 8.
+
+KING_ATTACKS[sq] - the (up to 8) squares a king on sq attacks.
+RAYS[dir][sq] - every square from sq to the edge of the board in dir,
+	not including sq itself.
+ROOK_LINES[sq] - the rank and file through sq, not including sq itself.
+BETWEEN[a][b] - the squares strictly between a and b when they share a
+	rank or file, otherwise empty.
+DISTANCE[a][b] - king moves from a to b, so 1 means adjacent.
+SYMMETRY[t][sq] - the square sq maps to under board symmetry t
+	bit 0 - mirror the files, bit 1 - mirror the ranks, bit 2 - transpose
+	(the tablebase folds boards with it, the heuristics orient with it).
+Rook moves are the rays cut short at the first blocker (the K).
+A rook on a sees b if b is on ROOK_LINES[a] and BETWEEN[a][b] is empty.
+
+The tables are built by make_bitboard_tables() in bitboard.h at compile
+	time, so they cost nothing at startup and need no initialization order.
+*/
+
+
+#include "bitboard.h"
+
+
+/* Squares a rook on sq attacks, stopping at (and including) blockers. */
+bitboard rook_attacks(int sq, bitboard blockers) {
+	bitboard attacks = 0;
+	bitboard ray, hit;
+	//up and right rays grow toward higher bits, nearest blocker is lowest.
+	ray = RAYS[RAY_UP][sq];
+	hit = ray & blockers;
+	if (hit) {
+		ray ^= RAYS[RAY_UP][__builtin_ctzll(hit)];
+	}
+	attacks |= ray;
+	ray = RAYS[RAY_RIGHT][sq];
+	hit = ray & blockers;
+	if (hit) {
+		ray ^= RAYS[RAY_RIGHT][__builtin_ctzll(hit)];
+	}
+	attacks |= ray;
+	//down and left rays, nearest blocker is highest.
+	ray = RAYS[RAY_DOWN][sq];
+	hit = ray & blockers;
+	if (hit) {
+		ray ^= RAYS[RAY_DOWN][63 - __builtin_clzll(hit)];
+	}
+	attacks |= ray;
+	ray = RAYS[RAY_LEFT][sq];
+	hit = ray & blockers;
+	if (hit) {
+		ray ^= RAYS[RAY_LEFT][63 - __builtin_clzll(hit)];
+	}
+	attacks |= ray;
+	return attacks;
+}
+
+
+/* Removes the lowest square from b and returns it. */
+int pop_lsb(bitboard& b) {
+	int sq = __builtin_ctzll(b);
+	b &= b - 1;
+	return sq;
+}
+
+
+// end of bitboard.cpp
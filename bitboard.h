@@ -0,0 +1,86 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+typedef unsigned long long bitboard;
+
+#define BIT(sq) (1ULL << (sq))
+
+enum RAY {RAY_UP=0, RAY_DOWN, RAY_LEFT, RAY_RIGHT};
+
+
+/* Attack and geometry tables, see bitboard.cpp
+All of them are filled in at compile time.
+*/
+struct bitboard_tables {
+	bitboard king_attacks[64];
+	bitboard rays[4][64];
+	bitboard rook_lines[64];
+	bitboard between[64][64];
+	unsigned char distance[64][64];
+	unsigned char symmetry[8][64];
+};
+
+constexpr bitboard_tables make_bitboard_tables() {
+	bitboard_tables t = {};
+	for (int a=0; a < 64; a++) {
+		int rank = a % 8;
+		int file = a / 8;
+		for (int f=file-1; f <= file+1; f++) {
+			for (int r=rank-1; r <= rank+1; r++) {
+				if (f < 0 || f > 7 || r < 0 || r > 7 || (f == file && r == rank)) {
+					continue;
+				}
+				t.king_attacks[a] |= BIT(f*8 + r);
+			}
+		}
+		for (int r=rank+1; r < 8; r++) {
+			t.rays[RAY_UP][a] |= BIT(file*8 + r);
+		}
+		for (int r=rank-1; r >= 0; r--) {
+			t.rays[RAY_DOWN][a] |= BIT(file*8 + r);
+		}
+		for (int f=file-1; f >= 0; f--) {
+			t.rays[RAY_LEFT][a] |= BIT(f*8 + rank);
+		}
+		for (int f=file+1; f < 8; f++) {
+			t.rays[RAY_RIGHT][a] |= BIT(f*8 + rank);
+		}
+		t.rook_lines[a] = t.rays[RAY_UP][a] | t.rays[RAY_DOWN][a] |
+			t.rays[RAY_LEFT][a] | t.rays[RAY_RIGHT][a];
+	}
+	for (int a=0; a < 64; a++) {
+		for (int b=0; b < 64; b++) {
+			int rd = a%8 - b%8;
+			int fd = a/8 - b/8;
+			rd = rd < 0 ? -rd : rd;
+			fd = fd < 0 ? -fd : fd;
+			t.distance[a][b] = (unsigned char)(rd > fd ? rd : fd);
+			for (int dir=0; dir < 4; dir++) {
+				if (t.rays[dir][a] & BIT(b)) {
+					t.between[a][b] = t.rays[dir][a] & ~t.rays[dir][b] & ~BIT(b);
+				}
+			}
+		}
+	}
+	for (int s=0; s < 8; s++) {
+		for (int a=0; a < 64; a++) {
+			int f = (s & 1) ? 7 - a/8 : a/8;
+			int r = (s & 2) ? 7 - a%8 : a%8;
+			t.symmetry[s][a] = (unsigned char)((s & 4) ? r*8 + f : f*8 + r);
+		}
+	}
+	return t;
+}
+
+inline constexpr bitboard_tables BITBOARDS = make_bitboard_tables();
+inline constexpr const bitboard (&KING_ATTACKS)[64] = BITBOARDS.king_attacks;
+inline constexpr const bitboard (&RAYS)[4][64] = BITBOARDS.rays;
+inline constexpr const bitboard (&ROOK_LINES)[64] = BITBOARDS.rook_lines;
+inline constexpr const bitboard (&BETWEEN)[64][64] = BITBOARDS.between;
+inline constexpr const unsigned char (&DISTANCE)[64][64] = BITBOARDS.distance;
+inline constexpr const unsigned char (&SYMMETRY)[8][64] = BITBOARDS.symmetry;
+
+bitboard rook_attacks(int sq, bitboard blockers);
+int pop_lsb(bitboard& b);
+
+#endif
@@ -0,0 +1,406 @@
+/* Test case corpora: reading, writing and converting
+Author: Phillip Stewart
+
+A corpus is a list of boards, optionally each with the result of playing it.
+	It comes in two formats, and every reader here takes either one.
+
+Text: one board per line in the format parse_state() reads,
+	"x.K(8,8),x.R(3,3),y.K(4,4)", optionally followed by a tab and the
+	result: the number of X moves to mate, "stalemate", "draw" (rook
+	taken) or "unfinished", as batch mode writes it. Anything after that
+	is ignored, so result files (like main_find --analyze output) can be
+	read back. Blank and unparseable lines are skipped and counted.
+
+Binary: an 8 byte header, CORPUS_MAGIC, CORPUS_VERSION and the record
+	size (3, or 4 with results), then one record per board:
+	K, R, k as square numbers (0-63), and the CORPUS_RESULT byte.
+	Records with a square out of range are skipped and counted.
+	That is 3-4 bytes instead of ~27 per board and nothing to parse,
+	and two runs over the same corpus can be compared with cmp.
+	(main_find <corpus> --record=<file> writes one.)
+
+PositionReader maps the whole file read-only and decodes it on demand:
+	next_batch() hands out the next READER_BATCH (or fewer) boards, and
+	only the mapping (paged in and out by the OS) depends on the file size.
+	It is safe to call from several threads, so workers can each pull a
+	batch, play it, and come back for more, and parsing overlaps the search.
+Boards are numbered in file order, so callers can break ties the same
+	way however the batches were spread over the threads.
+CorpusWriter::write_batch() takes the batches back, with results, in
+	whatever order the workers finish them, and writes them in file order.
+	The reordering is BatchOrder (corpus.h), which main_find's tester
+	also uses to print its rank lines.
+*/
+
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "helper.h"
+#include "play.h"
+#include "corpus.h"
+using namespace std;
+
+
+/* The result byte for a game that ended with outcome after turns X moves. */
+unsigned char corpus_result(int turns, GAME_OUTCOME outcome) {
+	if (outcome == GAME_MATE) {
+		return turns > CORPUS_MAX_MATE ? (int)CORPUS_UNFINISHED : turns;
+	} else if (outcome == GAME_STALEMATE) {
+		return CORPUS_STALEMATE;
+	} else if (outcome == GAME_ROOK_TAKEN) {
+		return CORPUS_ROOK_TAKEN;
+	}
+	return CORPUS_UNFINISHED;
+}
+
+
+/* A result byte in the text format, "" for CORPUS_NO_RESULT. */
+string corpus_result_string(unsigned char result) {
+	if (result <= CORPUS_MAX_MATE) {
+		stringstream ss;
+		ss << (int)result;
+		return ss.str();
+	} else if (result == CORPUS_STALEMATE) {
+		return "stalemate";
+	} else if (result == CORPUS_ROOK_TAKEN) {
+		return "draw";
+	} else if (result == CORPUS_UNFINISHED) {
+		return "unfinished";
+	}
+	return "";
+}
+
+
+/* The reverse of corpus_result_string()
+Output:	bool - false if str is not a result.
+*/
+bool parse_corpus_result(string str, unsigned char& result) {
+	if (str == "stalemate") {
+		result = CORPUS_STALEMATE;
+	} else if (str == "draw") {
+		result = CORPUS_ROOK_TAKEN;
+	} else if (str == "unfinished") {
+		result = CORPUS_UNFINISHED;
+	} else {
+		int turns = -1;
+		if (str.empty() || str.length() > 3 ||
+			str.find_first_not_of("0123456789") != string::npos) {
+			return false;
+		}
+		stringstream(str) >> turns;
+		if (turns > CORPUS_MAX_MATE) {
+			return false;
+		}
+		result = turns;
+	}
+	return true;
+}
+
+
+/* Reader constructor, nothing is open yet. */
+PositionReader::PositionReader() {
+	data = NULL;
+	size = 0;
+	pos = 0;
+	binary = false;
+	record_size = 0;
+	count = 0;
+	bad_lines = 0;
+}
+
+
+PositionReader::~PositionReader() {
+	close();
+}
+
+
+/* Maps filename for reading, binary corpora are recognized by their header.
+Output:	bool - false if the file can't be opened, or is a binary corpus
+			with a header this version doesn't know.
+*/
+bool PositionReader::open(string filename) {
+	close();
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+	size = st.st_size;
+	if (size > 0) {
+		void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			::close(fd);
+			size = 0;
+			return false;
+		}
+		//read front to back, let the kernel read ahead.
+		madvise(map, size, MADV_SEQUENTIAL);
+		data = (const char*)map;
+	}
+	::close(fd);
+	if (size >= CORPUS_MAGIC_LEN && memcmp(data, CORPUS_MAGIC, CORPUS_MAGIC_LEN) == 0) {
+		if (size < CORPUS_HEADER || data[CORPUS_MAGIC_LEN] != CORPUS_VERSION ||
+			(data[CORPUS_MAGIC_LEN + 1] != 3 && data[CORPUS_MAGIC_LEN + 1] != 4)) {
+			close();
+			return false;
+		}
+		binary = true;
+		record_size = data[CORPUS_MAGIC_LEN + 1];
+		pos = CORPUS_HEADER;
+	}
+	return true;
+}
+
+
+/* Unmaps the file. */
+void PositionReader::close() {
+	if (data) {
+		munmap((void*)data, size);
+	}
+	data = NULL;
+	size = 0;
+	pos = 0;
+	binary = false;
+	record_size = 0;
+	count = 0;
+	bad_lines = 0;
+}
+
+
+/* Decodes the next boards
+Input:	batch - cleared, then filled with up to max_count boards
+		first - set to the file order number of batch[0]
+		results - if not NULL, cleared and filled with each board's result
+			(CORPUS_NO_RESULT if the corpus has none)
+Output:	bool - false once the file is used up (batch is empty).
+*/
+bool PositionReader::next_batch(vector<state>& batch, long& first, int max_count,
+	vector<unsigned char>* results) {
+	batch.clear();
+	if (results) {
+		results->clear();
+	}
+	lock_guard<mutex> guard(lock);
+	first = count;
+	state s;
+	unsigned char result;
+	while (pos < size && (int)batch.size() < max_count) {
+		if (binary) {
+			if (size - pos < (size_t)record_size) {
+				//a partial record at the end
+				bad_lines++;
+				pos = size;
+				break;
+			}
+			const unsigned char* rec = (const unsigned char*)data + pos;
+			pos += record_size;
+			if (rec[0] > 63 || rec[1] > 63 || rec[2] > 63) {
+				//not squares, like an unparseable line in a text corpus
+				bad_lines++;
+				continue;
+			}
+			s = state(rec[0], rec[1], rec[2]);
+			result = record_size == 4 ? rec[3] : (unsigned char)CORPUS_NO_RESULT;
+		} else {
+			const char* line = data + pos;
+			const char* end = (const char*)memchr(line, '\n', size - pos);
+			if (!end) {
+				end = data + size;
+			}
+			pos = end - data + 1;
+			if (!parse_state_chars(line, end, s)) {
+				if (end > line && !(end - line == 1 && line[0] == '\r')) {
+					bad_lines++;
+				}
+				continue;
+			}
+			result = CORPUS_NO_RESULT;
+			const char* tab = (const char*)memchr(line, '\t', end - line);
+			if (tab) {
+				const char* field_end = tab + 1;
+				while (field_end < end && *field_end != '\t' && *field_end != '\r') {
+					field_end++;
+				}
+				if (!parse_corpus_result(string(tab + 1, field_end), result)) {
+					result = CORPUS_NO_RESULT;
+				}
+			}
+		}
+		batch.push_back(s);
+		if (results) {
+			results->push_back(result);
+		}
+		count++;
+	}
+	return batch.size() > 0;
+}
+
+
+/* Is the open file a binary corpus? */
+bool PositionReader::is_binary() {
+	return binary;
+}
+
+
+/* Does every record carry a result? (Text lines may or may not.) */
+bool PositionReader::has_results() {
+	return binary && record_size == 4;
+}
+
+
+/* Number of boards handed out so far. */
+long PositionReader::positions() {
+	lock_guard<mutex> guard(lock);
+	return count;
+}
+
+
+/* Number of non-blank lines (or trailing bytes) that were not boards. */
+long PositionReader::skipped() {
+	lock_guard<mutex> guard(lock);
+	return bad_lines;
+}
+
+
+/* Writer constructor, nothing is open yet. */
+CorpusWriter::CorpusWriter() {
+	file = NULL;
+	binary = false;
+	with_results = false;
+	good = false;
+}
+
+
+CorpusWriter::~CorpusWriter() {
+	close();
+}
+
+
+/* Creates filename and writes the binary header if needed
+Input:	binary - binary or text format
+		with_results - write the result of each board too
+Output:	bool - false if the file can't be written.
+*/
+bool CorpusWriter::open(string filename, bool binary, bool with_results) {
+	close();
+	this->binary = binary;
+	this->with_results = with_results;
+	order.clear();
+	file = fopen(filename.c_str(), binary ? "wb" : "w");
+	if (file == NULL) {
+		return false;
+	}
+	good = true;
+	if (binary) {
+		char header[CORPUS_HEADER];
+		memcpy(header, CORPUS_MAGIC, CORPUS_MAGIC_LEN);
+		header[CORPUS_MAGIC_LEN] = CORPUS_VERSION;
+		header[CORPUS_MAGIC_LEN + 1] = with_results ? 4 : 3;
+		good = fwrite(header, 1, CORPUS_HEADER, file) == CORPUS_HEADER;
+	}
+	return good;
+}
+
+
+/* Appends one board, result is ignored unless opened with_results.
+Boards that are not valid (pieces off the board or on the same square)
+	are not written, so every board written can be read back.
+Output:	bool - false if the board was not valid, or once any write has failed.
+*/
+bool CorpusWriter::write(state s, unsigned char result) {
+	if (!file || !s.is_valid()) {
+		return false;
+	}
+	if (binary) {
+		unsigned char rec[4] = {s.K, s.R, s.k, result};
+		int len = with_results ? 4 : 3;
+		good = (fwrite(rec, 1, len, file) == (size_t)len) && good;
+	} else {
+		string line = state_to_string(s);
+		if (with_results && result != CORPUS_NO_RESULT) {
+			line += "\t" + corpus_result_string(result);
+		}
+		line += "\n";
+		good = (fwrite(line.data(), 1, line.length(), file) == line.length()) && good;
+	}
+	return good;
+}
+
+
+/* Writes a batch from PositionReader::next_batch() with its results
+Safe to call from several threads. Batches that arrive before the ones
+	ahead of them in the file are held until those have been written
+	(see BatchOrder in corpus.h).
+*/
+void CorpusWriter::write_batch(long first, const vector<state>& batch,
+	const vector<unsigned char>& results) {
+	order.add(first, batch.size(), make_pair(batch, results),
+		[this](const pair<vector<state>, vector<unsigned char> >& b) {
+			for (int i=0; i < (int)b.first.size(); i++) {
+				write(b.first[i], b.second[i]);
+			}
+		});
+}
+
+
+/* Closes the file
+Output:	bool - false if anything failed to be written.
+*/
+bool CorpusWriter::close() {
+	if (!file) {
+		return false;
+	}
+	good = (fclose(file) == 0) && good;
+	file = NULL;
+	return good;
+}
+
+
+/* Converts a corpus to the other format: text to binary or binary to text.
+Text corpora get a result byte if their first board has a result.
+Output:	bool - false if either file can't be used.
+*/
+bool convert_corpus(string in_name, string out_name) {
+	PositionReader reader;
+	CorpusWriter writer;
+	if (!reader.open(in_name)) {
+		return false;
+	}
+	vector<state> batch;
+	vector<unsigned char> results;
+	long first;
+	bool opened = false;
+	while (reader.next_batch(batch, first, READER_BATCH, &results)) {
+		if (!opened) {
+			bool with_results = reader.is_binary() ? reader.has_results() :
+				results[0] != CORPUS_NO_RESULT;
+			if (!writer.open(out_name, !reader.is_binary(), with_results)) {
+				return false;
+			}
+			opened = true;
+		}
+		for (int i=0; i < (int)batch.size(); i++) {
+			writer.write(batch[i], results[i]);
+		}
+	}
+	if (!opened && !writer.open(out_name, !reader.is_binary(), false)) {
+		return false;
+	}
+	return writer.close();
+}
+
+
+// end of corpus.cpp
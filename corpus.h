@@ -0,0 +1,104 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+#include "helper.h"
+#include "play.h"
+
+#define READER_BATCH 256
+
+#define CORPUS_MAGIC "KRKPOS"
+#define CORPUS_MAGIC_LEN 6
+#define CORPUS_VERSION 1
+#define CORPUS_HEADER 8
+
+/* The optional result byte of a corpus record: 0-250 is mate in that many
+	X moves, the rest are the other ways a game ends (or no result).
+*/
+enum CORPUS_RESULT {CORPUS_MAX_MATE=250, CORPUS_UNFINISHED, CORPUS_STALEMATE,
+	CORPUS_ROOK_TAKEN, CORPUS_NO_RESULT=255};
+
+unsigned char corpus_result(int turns, GAME_OUTCOME outcome);
+std::string corpus_result_string(unsigned char result);
+bool parse_corpus_result(std::string str, unsigned char& result);
+
+/* Streams boards out of a text or binary corpus, see corpus.cpp */
+class PositionReader {
+public:
+	PositionReader();
+	~PositionReader();
+	bool open(std::string filename);
+	void close();
+	bool next_batch(std::vector<state>& batch, long& first, int max_count,
+		std::vector<unsigned char>* results = NULL);
+	bool is_binary();
+	bool has_results();
+	long positions();
+	long skipped();
+private:
+	const char* data;
+	size_t size;
+	size_t pos;
+	bool binary;
+	int record_size;
+	long count;
+	long bad_lines;
+	std::mutex lock;
+};
+
+/* Puts batches handed in by several threads back in file order.
+add() keeps a batch until every batch ahead of it has come in, then
+	calls emit on each batch that is now in order, under the lock.
+*/
+template <class T>
+class BatchOrder {
+public:
+	BatchOrder() {
+		next = 0;
+	}
+	void clear() {
+		std::lock_guard<std::mutex> guard(lock);
+		next = 0;
+		pending.clear();
+	}
+	template <class F>
+	void add(long first, long count, const T& batch, F emit) {
+		std::lock_guard<std::mutex> guard(lock);
+		pending[first] = std::make_pair(count, batch);
+		while (!pending.empty() && pending.begin()->first == next) {
+			emit(pending.begin()->second.second);
+			next += pending.begin()->second.first;
+			pending.erase(pending.begin());
+		}
+	}
+private:
+	long next;
+	std::map<long, std::pair<long, T> > pending;
+	std::mutex lock;
+};
+
+/* Writes boards (and results) as a text or binary corpus */
+class CorpusWriter {
+public:
+	CorpusWriter();
+	~CorpusWriter();
+	bool open(std::string filename, bool binary, bool with_results);
+	bool write(state s, unsigned char result);
+	void write_batch(long first, const std::vector<state>& batch,
+		const std::vector<unsigned char>& results);
+	bool close();
+private:
+	FILE* file;
+	bool binary;
+	bool with_results;
+	bool good;
+	BatchOrder<std::pair<std::vector<state>, std::vector<unsigned char> > > order;
+};
+
+bool convert_corpus(std::string in_name, std::string out_name);
+
+#endif
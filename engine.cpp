@@ -0,0 +1,232 @@
+/* Engine registry
+Author: Phillip Stewart
+
+Every move function for X and Y is registered here under a short name,
+	so the players and search depth can be picked on the command line
+	instead of by commenting calls in and out:
+	--x=<engine>	engine for player X (default DEFAULT_X_ENGINE)
+	--y=<engine>	engine for player Y (default DEFAULT_Y_ENGINE)
+	--depth=<n>		depth for the fixed-depth searches (default DEPTH)
+	--beam=<x>[,<y>]	widths for the beam search (default BEAM_X,BEAM_Y),
+					one number sets both
+The alpha-beta engine deepens until MOVE_TIME_MS runs out instead,
+	so it ignores --depth.
+
+All engines share the engine_fn signature. The search depth and beam
+	widths travel in the SearchContext, and Y engines simply ignore the
+	context's memory.
+*/
+
+
+#include <iostream>
+#include "helper.h"
+#include "move.h"
+#include "tablebase.h"
+#include "beam.h"
+#include "engine.h"
+using namespace std;
+
+
+/* Wrappers giving every move function the engine_fn signature */
+static unsigned char x_greedy(state s, SearchContext& ctx) {
+	return moveX(s, ctx);
+}
+
+static unsigned char x_maximax(state s, SearchContext& ctx) {
+	return maximax_moveX(s, ctx.depth, ctx);
+}
+
+static unsigned char x_ex_minimax(state s, SearchContext& ctx) {
+	return ex_minimax_moveX(s, ctx.depth, ctx);
+}
+
+static unsigned char x_alphabeta(state s, SearchContext& ctx) {
+	return alphabeta_moveX(s, ctx);
+}
+
+static unsigned char x_beam(state s, SearchContext& ctx) {
+	return beam_moveX(s, ctx);
+}
+
+static unsigned char x_tablebase(state s, SearchContext&) {
+	return tablebase_moveX(s);
+}
+
+static unsigned char y_greedy(state s, SearchContext&) {
+	return moveY(s);
+}
+
+static unsigned char y_minimax(state s, SearchContext& ctx) {
+	return minimax_moveY(s, ctx.depth, ctx);
+}
+
+static unsigned char y_additive(state s, SearchContext& ctx) {
+	return additive_minimax_moveY(s, ctx.depth, ctx);
+}
+
+static unsigned char y_beam(state s, SearchContext& ctx) {
+	return beam_moveY(s, ctx);
+}
+
+static unsigned char y_tablebase(state s, SearchContext&) {
+	return tablebase_moveY(s);
+}
+
+
+static const Engine ENGINES[] = {
+	{"greedy", true, false, x_greedy, "best heuristicX move, avoids repeats (moveX)"},
+	{"maximax", true, false, x_maximax, "maximax_moveX"},
+	{"ex_minimax", true, false, x_ex_minimax, "expected value search (ex_minimax_moveX)"},
+	{"alphabeta", true, false, x_alphabeta, "timed negamax search (alphabeta_moveX)"},
+	{"beam", true, false, x_beam, "beam search, --beam widths (beam_moveX)"},
+	{"tablebase", true, true, x_tablebase, "perfect play from krk.tb"},
+	{"greedy", false, false, y_greedy, "best heuristicY move (moveY)"},
+	{"minimax", false, false, y_minimax, "minimax_moveY"},
+	{"additive", false, false, y_additive, "additive_minimax_moveY"},
+	{"beam", false, false, y_beam, "beam search, --beam widths (beam_moveY)"},
+	{"tablebase", false, true, y_tablebase, "longest resistance from krk.tb"},
+};
+
+#define NUM_ENGINES (int)(sizeof(ENGINES) / sizeof(ENGINES[0]))
+
+
+/* All engines for one player, in registry order. */
+vector<const Engine*> list_engines(bool player_x) {
+	vector<const Engine*> engines;
+	for (int i=0; i < NUM_ENGINES; i++) {
+		if (ENGINES[i].player_x == player_x) {
+			engines.push_back(&ENGINES[i]);
+		}
+	}
+	return engines;
+}
+
+
+/* Looks up an engine by name, NULL if there is none for that player. */
+const Engine* find_engine(string name, bool player_x) {
+	for (int i=0; i < NUM_ENGINES; i++) {
+		if (ENGINES[i].player_x == player_x && name == ENGINES[i].name) {
+			return &ENGINES[i];
+		}
+	}
+	return NULL;
+}
+
+
+/* The engines used when no flags are given (see helper.h) */
+EngineConfig default_engines() {
+	EngineConfig cfg;
+	cfg.x = find_engine(DEFAULT_X_ENGINE, true);
+	cfg.y = find_engine(DEFAULT_Y_ENGINE, false);
+	cfg.depth = DEPTH;
+	cfg.x_beam = BEAM_X;
+	cfg.y_beam = BEAM_Y;
+	if (!cfg.x || !cfg.y) {
+		err("DEFAULT_X_ENGINE or DEFAULT_Y_ENGINE is not a registered engine.");
+	}
+	return cfg;
+}
+
+
+/* Applies one command-line argument to cfg
+Output:	bool - false if arg is not an engine flag (cfg is untouched).
+			Bad engine names, depths or widths are fatal.
+*/
+bool parse_engine_flag(string arg, EngineConfig& cfg) {
+	if (arg.compare(0, 4, "--x=") == 0 || arg.compare(0, 4, "--y=") == 0) {
+		bool player_x = (arg[2] == 'x');
+		const Engine* e = find_engine(arg.substr(4), player_x);
+		if (!e) {
+			print_engine_usage();
+			err("Unknown engine in " + arg);
+		}
+		if (player_x) {
+			cfg.x = e;
+		} else {
+			cfg.y = e;
+		}
+		return true;
+	} else if (arg.compare(0, 8, "--depth=") == 0) {
+		int depth = -1;
+		if (!parse_int(arg.substr(8), depth) || depth < 0 || depth > MAX_SEARCH_DEPTH) {
+			print_engine_usage();
+			err("Bad search depth in " + arg);
+		}
+		cfg.depth = depth;
+		return true;
+	} else if (arg.compare(0, 7, "--beam=") == 0) {
+		int x_beam = -1, y_beam = -1;
+		string widths = arg.substr(7);
+		size_t comma = widths.find(',');
+		bool good = parse_int(widths.substr(0, comma), x_beam);
+		if (comma == string::npos) {
+			y_beam = x_beam;
+		} else {
+			good = parse_int(widths.substr(comma + 1), y_beam) && good;
+		}
+		if (!good || x_beam < 1 || x_beam > MAX_MOVES || y_beam < 1 || y_beam > MAX_MOVES) {
+			print_engine_usage();
+			err("Bad beam widths in " + arg);
+		}
+		cfg.x_beam = x_beam;
+		cfg.y_beam = y_beam;
+		return true;
+	}
+	return false;
+}
+
+
+/* Sets up a game's search context with the depth and widths from cfg */
+void apply_config(SearchContext& ctx, const EngineConfig& cfg) {
+	ctx.depth = cfg.depth;
+	ctx.x_beam = cfg.x_beam;
+	ctx.y_beam = cfg.y_beam;
+}
+
+
+/* Loads whatever the chosen engines need. */
+void init_engines(const EngineConfig& cfg) {
+	if (cfg.x->needs_tablebase || cfg.y->needs_tablebase) {
+		tb_init();
+	}
+	vector<const Engine*> engines;
+	engines.push_back(cfg.x);
+	engines.push_back(cfg.y);
+	print_beam_depth(cfg, engines);
+}
+
+
+/* Says on stderr if the beam engines will search less deep than cfg.depth,
+	because the tree would not fit in BEAM_MAX_NODES (see beam_search_depth()).
+Input:	cfg - the depth and beam widths
+		engines - the engines that will play, nothing is printed if
+			none of them is a beam engine
+*/
+void print_beam_depth(const EngineConfig& cfg, const vector<const Engine*>& engines) {
+	bool beam = false;
+	for (int i=0; i < (int)engines.size(); i++) {
+		if (engines[i]->fn == x_beam || engines[i]->fn == y_beam) {
+			beam = true;
+		}
+	}
+	int depth = beam_search_depth(cfg.depth, cfg.x_beam, cfg.y_beam);
+	if (beam && depth < cfg.depth) {
+		cerr << "Beam search depth " << cfg.depth << " lowered to " << depth
+			<< " for beam " << cfg.x_beam << "," << cfg.y_beam
+			<< " (BEAM_MAX_NODES is " << BEAM_MAX_NODES << ").\n";
+	}
+}
+
+
+/* Lists the engine flags and engines on stderr */
+void print_engine_usage() {
+	cerr << "Engine flags: --x=<engine> --y=<engine> --depth=<0-" << MAX_SEARCH_DEPTH << ">"
+		<< " --beam=<x>[,<y>] (1-" << MAX_MOVES << ")\n";
+	for (int i=0; i < NUM_ENGINES; i++) {
+		cerr << "  --" << (ENGINES[i].player_x ? "x" : "y") << "=" << ENGINES[i].name;
+		cerr << string(14 - string(ENGINES[i].name).length(), ' ') << ENGINES[i].description << endl;
+	}
+}
+
+
+// end of engine.cpp
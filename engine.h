@@ -0,0 +1,38 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <string>
+#include <vector>
+#include "helper.h"
+#include "move.h"
+
+/* A move function for one player, see engine.cpp */
+typedef unsigned char (*engine_fn)(state s, SearchContext& ctx);
+
+struct Engine {
+	const char* name;
+	bool player_x;
+	bool needs_tablebase;
+	engine_fn fn;
+	const char* description;
+};
+
+/* The engines, search depth and beam widths a game is played with */
+struct EngineConfig {
+	const Engine* x;
+	const Engine* y;
+	int depth;
+	int x_beam;
+	int y_beam;
+};
+
+std::vector<const Engine*> list_engines(bool player_x);
+const Engine* find_engine(std::string name, bool player_x);
+EngineConfig default_engines();
+bool parse_engine_flag(std::string arg, EngineConfig& cfg);
+void apply_config(SearchContext& ctx, const EngineConfig& cfg);
+void init_engines(const EngineConfig& cfg);
+void print_beam_depth(const EngineConfig& cfg, const std::vector<const Engine*>& engines);
+void print_engine_usage();
+
+#endif
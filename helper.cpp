@@ -6,24 +6,57 @@ Helper functions for the chess game.
 
 
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <sstream>
 #include <vector>
 #include "helper.h"
+#include "bitboard.h"
+#include "profile.h"
+#include "corpus.h"
 using namespace std;
 
 
-#define TRY_ADD_MOVE_Y s2=make_move(s,move,false);if(!y_in_check(s2)&&!kings_too_close(s2)){moves.push_back(move);}
-#define TRY_ADD_KING if(K_can_move(s,move)){moves.push_back(move);}
 #define INPUT_FILE "testCase.txt"
 
 
+/* Random numbers for the Zobrist keys, one per piece and square,
+	plus one that is toggled every time the side to move changes.
+Filled in at compile time from a fixed seed (splitmix64),
+	so keys are the same in every run and every program.
+*/
+struct zobrist_keys {
+	unsigned long long piece[3][64];
+	unsigned long long side;
+};
+
+constexpr zobrist_keys make_zobrist_keys() {
+	zobrist_keys z = {};
+	unsigned long long seed = 0x4b52536b4b52536bULL;
+	for (int i=0; i <= 3*64; i++) {
+		seed += 0x9e3779b97f4a7c15ULL;
+		unsigned long long x = seed;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		x = x ^ (x >> 31);
+		if (i < 3*64) {
+			z.piece[i/64][i%64] = x;
+		} else {
+			z.side = x;
+		}
+	}
+	return z;
+}
+
+constexpr zobrist_keys ZOBRIST = make_zobrist_keys();
+enum ZOBRIST_PIECE {Z_K=0, Z_R, Z_k};
+
+
 /* State constructor */
 state::state() {
 	K = 0;
 	R = 0;
 	k = 0;
+	key = state_key(*this, true);
 }
 
 /* State constuctor with values */
@@ -31,6 +64,22 @@ state::state(unsigned char a, unsigned char b, unsigned char c) {
 	K = a;
 	R = b;
 	k = c;
+	key = state_key(*this, true);
+}
+
+
+/* Computes the Zobrist key of a board from scratch.
+A captured rook (R == 255) adds nothing.
+*/
+unsigned long long state_key(state s, bool x_to_move) {
+	unsigned long long key = ZOBRIST.piece[Z_K][s.K % 64] ^ ZOBRIST.piece[Z_k][s.k % 64];
+	if (s.R != 255) {
+		key ^= ZOBRIST.piece[Z_R][s.R % 64];
+	}
+	if (!x_to_move) {
+		key ^= ZOBRIST.side;
+	}
+	return key;
 }
 
 
@@ -68,10 +117,14 @@ void err(string msg) {
 
 
 /* Lists all valid moves for player X
-I used macros for these as there is a lot of repetition...
+K may step to any square not next to k (or onto R),
+	R slides along its rank and file until it runs into K.
 */
-vector<unsigned char> list_all_moves_x(state s) {
-	vector<unsigned char> moves;
+MoveList list_all_moves_x(state s) {
+	if (PROFILE_SEARCH) {
+		search_stats.move_gens++;
+	}
+	MoveList moves;
 	unsigned char move;
 
 	//In case something went wrong and R can capture k:
@@ -81,162 +134,50 @@ vector<unsigned char> list_all_moves_x(state s) {
 		return moves;
 	}
 
-	int rank, file;
 	//King
-	rank = s.K % 8;
-	file = s.K / 8;
-	if (rank > 0) {
-		//add below
-		move = s.K - 1;
-		TRY_ADD_KING
-		if (file > 0) {
-			//add down-left
-			move = s.K - 9;
-			TRY_ADD_KING
-		}
-		if (file < 7) {
-			//add down-right
-			move = s.K + 7;
-			TRY_ADD_KING
-		}
-	}
-	if (rank < 7) {
-		//add above
-		move = s.K + 1;
-		TRY_ADD_KING
-		if (file > 0) {
-			//add up-left
-			move = s.K - 7;
-			TRY_ADD_KING
-		}
-		if (file < 7) {
-			//add up-right
-			move = s.K + 9;
-			TRY_ADD_KING
-		}
-	}
-	if (file > 0) {
-		//add left
-		move = s.K - 8;
-		TRY_ADD_KING
+	bitboard targets = KING_ATTACKS[s.K] & ~KING_ATTACKS[s.k] & ~BIT(s.R) & ~BIT(s.k);
+	while (targets) {
+		moves.push_back((unsigned char)pop_lsb(targets));
 	}
-	if (file < 7) {
-		//add right
-		move = s.K + 8;
-		TRY_ADD_KING
-	} 
 	//Rook
-	rank = s.R % 8;
-	file = s.R / 8;
-
-	//if rank clear:
-	if (rank != s.K%8) {
-		for (move=rank; move<64; move+=8) {
-			if (move != s.R) {
-				moves.push_back((unsigned char)(move + 64));
-			}
-		}
-	} else { //K in rank...
-		if (file > 0) {
-			move = s.R - 8;
-			while (move >= 0 && move != s.K) {
-				if (move > 200) {//watch out for unsigned overflow...
-					break;
-				}
-				moves.push_back((unsigned char)(move + 64));
-				move -= 8;
-			}
-		}
-		if (file < 7) {
-			move = s.R + 8;
-			while (move < 64 && move != s.K) {
-				moves.push_back((unsigned char)(move + 64));
-				move += 8;
-			}
-		}
-	}
-	//if file is clear
-	if (file != s.K/8) {
-		for (move=file*8; move<(file+1)*8; move++) {
-			if (move != s.R) {
-				moves.push_back((unsigned char)(move + 64));
-			}
-		}
-	} else {//K in file...
-		if (rank > 0) {
-			move = s.R - 1;
-			while (move%8 != 7 && move != s.K) {
-				moves.push_back((unsigned char)(move + 64));
-				move -= 1;
-			}
-		}
-		if (rank < 7) {
-			move = s.R + 1;
-			while (move%8 != 0 && move != s.K) {
-				moves.push_back((unsigned char)(move + 64));
-				move += 1;
-			}
-		}
+	targets = rook_attacks(s.R, BIT(s.K)) & ~BIT(s.K);
+	while (targets) {
+		moves.push_back((unsigned char)(pop_lsb(targets) + 64));
 	}
 	return moves;
 }
 
 
-/* Lists all valid moves for player Y */
-vector<unsigned char> list_all_moves_y(state s) {
-	vector<unsigned char> moves;
-	unsigned char move;
-	int rank, file;
-	state s2(0,0,0);
-	rank = s.k % 8;
-	file = s.k / 8;
-	if (rank > 0) {
-		//add below
-		move = s.k - 1;
-		TRY_ADD_MOVE_Y
-		if (file > 0) {
-			//add down-left
-			move = s.k - 9;
-			TRY_ADD_MOVE_Y
-		}
-		if (file < 7) {
-			//add down-right
-			move = s.k + 7;
-			TRY_ADD_MOVE_Y
-		}
+/* Squares player Y's king may move to
+k may not step next to K or onto a square R attacks.
+	k itself does not block R, since it is the piece moving off the line.
+*/
+static bitboard y_escape_squares(state s) {
+	bitboard targets = KING_ATTACKS[s.k] & ~KING_ATTACKS[s.K] & ~BIT(s.K);
+	if (s.R != 255) {
+		targets &= ~rook_attacks(s.R, BIT(s.K));
 	}
-	if (rank < 7) {
-		//add above
-		move = s.k + 1;
-		TRY_ADD_MOVE_Y
-		if (file > 0) {
-			//add up-left
-			move = s.k - 7;
-			TRY_ADD_MOVE_Y
-		}
-		if (file < 7) {
-			//add up-right
-			move = s.k + 9;
-			TRY_ADD_MOVE_Y
-		}
+	return targets;
+}
+
+
+/* Lists all valid moves for player Y, see y_escape_squares() */
+MoveList list_all_moves_y(state s) {
+	if (PROFILE_SEARCH) {
+		search_stats.move_gens++;
 	}
-	if (file > 0) {
-		//add left
-		move = s.k - 8;
-		TRY_ADD_MOVE_Y
+	MoveList moves;
+	bitboard targets = y_escape_squares(s);
+	while (targets) {
+		moves.push_back((unsigned char)pop_lsb(targets));
 	}
-	if (file < 7) {
-		//add right
-		move = s.k + 8;
-		TRY_ADD_MOVE_Y
-	} 
 	return moves;
 }
 
 
 /* Called to validate player input. */
 bool is_valid_move(state s, unsigned char move, bool player_x) {
-	vector<unsigned char> moves;
+	MoveList moves;
 	if (player_x) {
 		moves = list_all_moves_x(s);
 		for (int i=0; i < (int)moves.size(); i++) {
@@ -270,17 +211,24 @@ Input:	state s - current state of the board
 				char %8 = row, (1-8 zero-based)
 		bool player_x - is it Xs move?
 Output:	state - The updated state of the board.
+			s.key is updated for the moved (or captured) piece and
+			the change of side to move.
 */
 state make_move(state s, unsigned char move, bool player_x) {
+	s.key ^= ZOBRIST.side;
 	if (player_x) {
 		if (move < 64) { // move K
+			s.key ^= ZOBRIST.piece[Z_K][s.K] ^ ZOBRIST.piece[Z_K][move];
 			s.K = move;
 		} else { // move R
+			s.key ^= ZOBRIST.piece[Z_R][s.R] ^ ZOBRIST.piece[Z_R][move - 64];
 			s.R = move - 64;
 		}
 	} else { // player y, move k
+		s.key ^= ZOBRIST.piece[Z_k][s.k] ^ ZOBRIST.piece[Z_k][move];
 		s.k = move;
 		if (s.k == s.R) {
+			s.key ^= ZOBRIST.piece[Z_R][s.R];
 			s.R = 255;
 		}
 	}
@@ -301,24 +249,7 @@ bool K_can_move(state s, unsigned char move) {
 
 /* Determine's if the Kings are within square move of eachother. */
 bool kings_too_close(state s) {
-	//check for wraparound first...
-	if (((s.k%8 == 0) && (s.K%8 == 7)) ||
-		((s.k%8 == 7) && (s.K%8 == 0)) ||
-		((s.k/8 == 0) && (s.K/8 == 7)) ||
-		((s.k/8 == 7) && (s.K/8 == 0))) {
-		return false;
-	} else if (s.k - 9 == s.K ||
-		s.k - 8 == s.K ||
-		s.k - 7 == s.K ||
-		s.k - 1 == s.K ||
-		s.k + 1 == s.K ||
-		s.k + 7 == s.K ||
-		s.k + 8 == s.K ||
-		s.k + 9 == s.K) {
-		return true;
-	} else {
-		return false;
-	}
+	return (KING_ATTACKS[s.K] & BIT(s.k)) != 0;
 }
 
 
@@ -330,41 +261,15 @@ bool y_in_check(state s) {
 	if (s.R == 255) {
 		return false;
 	}
-	unsigned char Krank = s.K % 8;
-	unsigned char Rrank = s.R % 8;
-	unsigned char krank = s.k % 8;
-	unsigned char Kfile = s.K / 8;
-	unsigned char Rfile = s.R / 8;
-	unsigned char kfile = s.k / 8;
-	if (krank == Rrank) {
-		//if blocked by K
-		if (krank == Krank) {
-			if (kfile < Kfile && Kfile < Rfile) {
-				return false;
-			} else if (Rfile < Kfile && Kfile < kfile) {
-				return false;
-			} else {
-				return true;
-			}
-		} else {
-			return true;
-		}
-	} else if (kfile == Rfile) {
-		//if blocked by K
-		if (kfile == Kfile) {
-			if (krank < Krank && Krank < Rrank) {
-				return false;
-			} else if (Rrank < Krank && Krank < krank) {
-				return false;
-			} else {
-				return true;
-			}
-		} else {
-			return true;
-		}
-	} else {
-		return false;
-	}
+	return ((ROOK_LINES[s.R] & BIT(s.k)) != 0) & ((BETWEEN[s.R][s.k] & BIT(s.K)) == 0);
+}
+
+
+/* Determine's if player Y has any legal move
+Same as list_all_moves_y(s).size() != 0, without building the list.
+*/
+bool has_any_legal_move_y(state s) {
+	return y_escape_squares(s) != 0;
 }
 
 
@@ -372,8 +277,7 @@ bool y_in_check(state s) {
 Note: player x cannot be in check or mate...
 */
 bool in_checkmate(state s) {
-	//TODO: smaller footprint than list_all_moves??
-	if (y_in_check(s) && list_all_moves_y(s).size() == 0) {
+	if (y_in_check(s) && !has_any_legal_move_y(s)) {
 		if (DEBUG_VERBOSE) {
 			cout << "Checkmate found!\n";
 		}
@@ -384,6 +288,12 @@ bool in_checkmate(state s) {
 }
 
 
+/* Determine's if player Y is stalemated: not in check, but can't move. */
+bool in_stalemate(state s) {
+	return !y_in_check(s) && !has_any_legal_move_y(s);
+}
+
+
 /* Prints an ascii version of the board
 Player X has K,R. Player Y has k.
 Input:	state s - current state of the board
@@ -496,37 +406,96 @@ state get_initial_state() {
 }
 
 
-/* Read initial state from file. */
+/* Read initial state from file (the first board in it). */
 state get_state_from_file() {
 	if (VERBOSE_RESULTS) {
 		cout << "\n---------------------------------------\n";
 		cout << "Loading initial game-state from file...\n";
 	}
-	ifstream infile;
-	infile.open(INPUT_FILE);
-	string line;
-	getline(infile, line);
-
-	int a,b,c,d,e,f;
-	sscanf(line.c_str(),"x.K(%d,%d),x.R(%d,%d),y.K(%d,%d)",&a,&b,&c,&d,&e,&f);
-
-	char K = (char)((a-1)*8 + (b-1));
-	char R = (char)((c-1)*8 + (d-1));
-	char k = (char)((e-1)*8 + (f-1));
-
-	state s(K, R, k);
-	if (!s.is_valid()) {
+	PositionReader reader;
+	vector<state> batch;
+	long first;
+	if (!reader.open(INPUT_FILE) || !reader.next_batch(batch, first, 1) ||
+		!batch[0].is_valid()) {
 		err("Invalid board configuration.");
-	} else if (VERBOSE_RESULTS) {
-		cout << "Loaded game:\n" << line << endl;
+	}
+	state s = batch[0];
+	if (VERBOSE_RESULTS) {
+		cout << "Loaded game:\n" << state_to_string(s) << endl;
 		cout << "---------------------------------------\n";
 	}
-	infile.close();
 	print_board(s);
 	return s;
 }
 
 
+/* Parses a whole string as a number, for command line flags
+Input:	string str - ex: "3", as in --depth=3
+		int& value - set to the number if str is one
+Output:	bool - false if str is empty or has anything after the number.
+*/
+bool parse_int(string str, int& value) {
+	stringstream ss(str);
+	string rest;
+	int n;
+	if (!(ss >> n)) {
+		return false;
+	}
+	ss >> rest;
+	if (!rest.empty()) {
+		return false;
+	}
+	value = n;
+	return true;
+}
+
+
+/* Parses a board in the test case format
+Input:	string line - ex: "x.K(8,8),x.R(3,3),y.K(4,4)"
+			coordinates are (file,rank), 1-8.
+		state& s - set to the board if the line parses.
+Output:	bool - false if the line is not a board.
+*/
+bool parse_state(string line, state& s) {
+	return parse_state_chars(line.data(), line.data() + line.length(), s);
+}
+
+
+/* parse_state() for a board in [p, end), which need not be a string.
+Anything after the board is ignored.
+*/
+bool parse_state_chars(const char* p, const char* end, state& s) {
+	static const char PATTERN[] = "x.K(#,#),x.R(#,#),y.K(#,#)";
+	const int len = sizeof(PATTERN) - 1;
+	int coords[6];
+	int n = 0;
+	if (end - p < len) {
+		return false;
+	}
+	for (int i=0; i < len; i++) {
+		if (PATTERN[i] == '#') {
+			if (p[i] < '1' || p[i] > '8') {
+				return false;
+			}
+			coords[n++] = p[i] - '1';
+		} else if (p[i] != PATTERN[i]) {
+			return false;
+		}
+	}
+	s = state(coords[0]*8 + coords[1], coords[2]*8 + coords[3], coords[4]*8 + coords[5]);
+	return true;
+}
+
+
+/* Writes a board in the test case format (the reverse of parse_state). */
+string state_to_string(state s) {
+	char buf[80];
+	sprintf(buf,"x.K(%d,%d),x.R(%d,%d),y.K(%d,%d)",
+		s.K/8 + 1, s.K%8 + 1, s.R/8 + 1, s.R%8 + 1, s.k/8 + 1, s.k%8 + 1);
+	return string(buf);
+}
+
+
 /* Read initial state from stdin. */
 state get_state_from_stdin() {
 	string response;
@@ -3,18 +3,36 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 
 #define VERBOSE_RESULTS true
 #define DEBUG_VERBOSE false
+#define PROFILE_SEARCH false
 #define DEPTH 2
+#define MAX_MOVES 32
+#define MOVE_TIME_MS 100
+#define MAX_SEARCH_DEPTH 8
+#define BEAM_X 5
+#define BEAM_Y 3
+#define DEFAULT_X_ENGINE "tablebase"
+#define DEFAULT_Y_ENGINE "additive"
+#define HEURISTIC_TABLES true
+#define VERIFY_HEURISTIC_TABLES false
+#define HEURISTIC_AVX2 true
 
 enum DIR {NONE=0, UP, DOWN, LEFT, RIGHT, UL, UR, DL, DR};
 
+/* Board state
+key is a Zobrist hash of the board and side to move. make_move() keeps it
+	up to date, the constructors start it with X to move.
+	Code that edits K, R or k directly (like orient()) leaves it stale.
+*/
 class state {
 public:
 	unsigned char K;
 	unsigned char R;
 	unsigned char k;
+	unsigned long long key;
 	state();
 	state(unsigned char a, unsigned char b, unsigned char c);
 	bool is_valid();
@@ -23,15 +41,89 @@ public:
 bool operator==(const state& a, const state& b);
 bool operator<(const state& a, const state& b);
 
+
+/* Fixed capacity list for moves
+KR-k has at most 8 king moves and 14 rook moves, so the lists fit in a
+	small array on the stack and move generation never touches the heap.
+Supports the parts of std::vector the move functions use.
+resize() pads with T() like std::vector, but may not exceed the capacity N.
+pick_best(i) is a lazy sort+reverse: called for i = 0, 1, 2... it puts the
+	items in the same (highest first) order, but only as far as the caller
+	looks, so taking the best move or two is one pass over the list.
+	best_first(n) orders the best n items the same way.
+*/
+template <typename T, int N>
+class FixedList {
+public:
+	FixedList() {
+		count = 0;
+	}
+	void push_back(const T& item) {
+		items[count++] = item;
+	}
+	void resize(int n) {
+		for (int i=count; i < n; i++) {
+			items[i] = T();
+		}
+		count = n;
+	}
+	void clear() {
+		count = 0;
+	}
+	T& pick_best(int i) {
+		int best = i;
+		for (int j=i+1; j < count; j++) {
+			if (items[best] < items[j]) {
+				best = j;
+			}
+		}
+		if (best != i) {
+			T temp = items[i];
+			items[i] = items[best];
+			items[best] = temp;
+		}
+		return items[i];
+	}
+	void best_first(int n) {
+		for (int i=0; i < n && i < count; i++) {
+			pick_best(i);
+		}
+	}
+	int size() const {
+		return count;
+	}
+	T& operator[](int i) {
+		return items[i];
+	}
+	const T& operator[](int i) const {
+		return items[i];
+	}
+	T* begin() {
+		return items;
+	}
+	T* end() {
+		return items + count;
+	}
+private:
+	T items[N];
+	int count;
+};
+
+typedef FixedList<unsigned char, MAX_MOVES> MoveList;
+typedef FixedList<std::pair<int, unsigned char>, MAX_MOVES> RankedMoves;
+
+unsigned long long state_key(state s, bool x_to_move);
 void err(std::string msg);
-std::vector<unsigned char> list_all_moves_x(state s);
-std::vector<unsigned char> list_all_moves_y(state s);
+MoveList list_all_moves_x(state s);
+MoveList list_all_moves_y(state s);
 bool is_valid_move(state s, unsigned char move, bool player_x);
 state make_move(state s, unsigned char move, bool player_x);
 bool K_can_move(state s, unsigned char move);
 bool kings_too_close(state s);
 bool y_in_check(state s);
+bool has_any_legal_move_y(state s);
 bool in_checkmate(state s);
+bool in_stalemate(state s);
 void print_board(state s);
 std::string board_string(state s);
 bool get_is_test();
@@ -39,6 +131,10 @@ unsigned int get_max_turns();
 state get_initial_state();
 state get_state_from_file();
 state get_state_from_stdin();
+bool parse_int(std::string str, int& value);
+bool parse_state(std::string line, state& s);
+bool parse_state_chars(const char* p, const char* end, state& s);
+std::string state_to_string(state s);
 bool ask_x();
 unsigned char convert_PGN_to_char(std::string square);
 unsigned char convert_PGN_to_move(std::string move_str, bool player_x);
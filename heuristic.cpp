@@ -13,11 +13,369 @@ Player Y should avoid moving toward the edge, and annoy R.
 There is a lot more progress to be made with Y than with X...
 
 I left older versions of the heuristics in here, but they can be disregarded.
+
+Both heuristics only depend on the 3 squares, so with HEURISTIC_TABLES
+	init_heuristic_tables() evaluates every board once at startup and
+	heuristicX()/heuristicY() become a single table load.
+	The *_live() functions are the real heuristics.
+	With VERIFY_HEURISTIC_TABLES the tables are checked against them.
+
+heuristicY_batch() scores every one of Y's moves from a board at once,
+	which is what the Y searches need. With the tables it reads them from
+	the one 64 entry row all the moves share. Without them (and to build
+	the table) heuristicY_lanes() runs heuristicY_live() on 8 boards at a
+	time: the orientation is done per board, then the scoring is done
+	in the 8 16-bit lanes of an SSE2 register, with masks in place of the
+	branches. Every Y value fits in 16 bits. Without SSE2 it just calls
+	heuristicY_live() on each board.
+
+heuristicX_batch() does the same for X's moves. heuristicX_live() is split
+	into orient_x(), which turns the board and splits it into ranks and
+	files, and score_x(), the branch tree. heuristicX_lanes() orients every
+	board and lays them out as one array per field (x_lanes), then scores
+	8 boards per AVX2 instruction, every branch of score_x() computed on
+	every lane and picked with masks. The AVX2 code is compiled for that
+	target only, and is only used if the CPU has it (and HEURISTIC_AVX2);
+	otherwise each board goes through score_x().
 */
 
 
+#include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HX_AVX2
+#include <immintrin.h>
+#endif
 #include "helper.h"
+#include "bitboard.h"
 #include "heuristic.h"
+#include "profile.h"
+using namespace std;
+
+
+#define H_TABLE_SIZE (64*64*64)
+
+
+#ifdef __SSE2__
+/* Per lane: mask ? a : b (mask lanes are all ones or all zeros) */
+static inline __m128i select_epi16(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+/* A board as heuristicX_live() scores it (see orient_x()) */
+struct x_board {
+	int dir;
+	unsigned char Krank, Kfile, Rrank, Rfile, krank, kfile;
+};
+
+/* The same for up to MAX_MOVES boards, one array per field */
+struct x_lanes {
+	int dir[MAX_MOVES];
+	int Krank[MAX_MOVES];
+	int Kfile[MAX_MOVES];
+	int Rrank[MAX_MOVES];
+	int Rfile[MAX_MOVES];
+	int krank[MAX_MOVES];
+	int kfile[MAX_MOVES];
+};
+
+static x_board orient_x(state s);
+static int score_x(x_board b);
+#ifdef HX_AVX2
+static void score_x_avx2(const x_lanes& l, int first, int* out);
+#endif
+
+
+static bool avx2_allowed = HEURISTIC_AVX2;
+
+
+/* Whether heuristicX_lanes() should use AVX2 */
+static bool use_avx2() {
+#ifdef HX_AVX2
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	return avx2_allowed && avx2;
+#else
+	return false;
+#endif
+}
+
+
+/* Turns the AVX2 path of heuristicX_lanes() off or back on, for testing
+	the fallback. Must not be called while threads are searching.
+Input:	bool on - false for score_x() on every board
+Output:	bool - true if the AVX2 path is now used
+*/
+bool heuristic_avx2(bool on) {
+	avx2_allowed = HEURISTIC_AVX2 && on;
+	return use_avx2();
+}
+
+/* X values reach 65536, Y values stay well inside 16 bits
+	(capturing the rook, the only larger Y value, is never looked up).
+*/
+int hX_table[H_TABLE_SIZE];
+short hY_table[H_TABLE_SIZE];
+bool heuristic_tables_ready = false;
+
+
+/* Fills the heuristic tables from the live functions.
+Must be called before any threads start searching.
+*/
+void init_heuristic_tables() {
+	if (heuristic_tables_ready) {
+		return;
+	}
+	state boards[8];
+	int hY[8];
+	for (int i=0; i < H_TABLE_SIZE; i++) {
+		boards[i%8] = state(i/4096, (i/64)%64, i%64);
+		if (i%8 == 7) {
+			heuristicX_lanes(boards, 8, &hX_table[i-7]);
+			heuristicY_lanes(boards, 8, hY);
+			for (int j=0; j < 8; j++) {
+				hY_table[i-7 + j] = (short)hY[j];
+			}
+		}
+	}
+	heuristic_tables_ready = true;
+	if (VERIFY_HEURISTIC_TABLES) {
+		int bad = verify_heuristic_tables();
+		if (bad > 0) {
+			cerr << bad << " heuristic table entries are wrong.\n";
+			err("Heuristic tables do not match the heuristics.");
+		}
+	}
+}
+
+
+/* Compares every table entry with the live heuristics.
+Output:	int - number of boards where they differ.
+*/
+int verify_heuristic_tables() {
+	int bad = 0;
+	for (int i=0; i < H_TABLE_SIZE; i++) {
+		state s(i/4096, (i/64)%64, i%64);
+		if (hX_table[i] != heuristicX_live(s) ||
+			hY_table[i] != heuristicY_live(s)) {
+			bad++;
+		}
+	}
+	return bad;
+}
+
+
+/* Heuristic for player X, from the table if it is loaded. */
+int heuristicX(state s) {
+	if (PROFILE_SEARCH) {
+		search_stats.heuristic_calls++;
+	}
+	if (heuristic_tables_ready && s.R != 255) {
+		return hX_table[(s.K*64 + s.R)*64 + s.k];
+	}
+	return heuristicX_live(s);
+}
+
+
+/* Heuristic for player Y, from the table if it is loaded. */
+int heuristicY(state s) {
+	if (PROFILE_SEARCH) {
+		search_stats.heuristic_calls++;
+	}
+	if (heuristic_tables_ready && s.R != 255) {
+		return hY_table[(s.K*64 + s.R)*64 + s.k];
+	}
+	return heuristicY_live(s);
+}
+
+
+/* heuristicY() of the board after each of Y's moves
+Input:	state s - the board, Y to move
+		MoveList moves - Y's moves from s
+		int* out - gets heuristicY(make_move(s, moves[i], false)) for each i
+*/
+void heuristicY_batch(state s, const MoveList& moves, int* out) {
+	int n = moves.size();
+	if (PROFILE_SEARCH) {
+		search_stats.heuristic_calls += n;
+	}
+	if (s.R == 255) {
+		for (int i=0; i < n; i++) {
+			out[i] = 65536;
+		}
+		return;
+	}
+	if (heuristic_tables_ready) {
+		const short* row = &hY_table[(s.K*64 + s.R)*64];
+		for (int i=0; i < n; i++) {
+			out[i] = (moves[i] == s.R) ? 65536 : row[moves[i]];
+		}
+		return;
+	}
+	state boards[8];
+	for (int i=0; i < n; i += 8) {
+		int lanes = (n - i < 8) ? n - i : 8;
+		for (int j=0; j < lanes; j++) {
+			boards[j] = s;
+			boards[j].k = moves[i+j];
+		}
+		heuristicY_lanes(boards, lanes, out + i);
+		//taking the rook, the board would have R == 255
+		for (int j=0; j < lanes; j++) {
+			if (moves[i+j] == s.R) {
+				out[i+j] = 65536;
+			}
+		}
+	}
+}
+
+
+/* heuristicY_live() of up to 8 boards at once (see the top of the file)
+Input:	boards, n - the boards, none with the rook taken
+		int* out - gets the n values
+*/
+void heuristicY_lanes(const state* boards, int n, int* out) {
+#ifdef __SSE2__
+	short Kr[8] = {0}, Kf[8] = {0}, Rr[8] = {0}, Rf[8] = {0}, kr[8] = {0}, kf[8] = {0};
+	for (int i=0; i < n; i++) {
+		state s = dir_and_orientY(boards[i]);
+		Kr[i] = s.K % 8;
+		Kf[i] = s.K / 8;
+		Rr[i] = s.R % 8;
+		Rf[i] = s.R / 8;
+		kr[i] = s.k % 8;
+		kf[i] = s.k / 8;
+	}
+	__m128i Krank = _mm_loadu_si128((const __m128i*)Kr);
+	__m128i Kfile = _mm_loadu_si128((const __m128i*)Kf);
+	__m128i Rrank = _mm_loadu_si128((const __m128i*)Rr);
+	__m128i Rfile = _mm_loadu_si128((const __m128i*)Rf);
+	__m128i krank = _mm_loadu_si128((const __m128i*)kr);
+	__m128i kfile = _mm_loadu_si128((const __m128i*)kf);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i two = _mm_set1_epi16(2);
+	const __m128i seven = _mm_set1_epi16(7);
+
+	//distance from the center, less 500 on the edge
+	__m128i y_dist = _mm_sub_epi16(_mm_add_epi16(krank, krank), seven);
+	y_dist = _mm_max_epi16(y_dist, _mm_sub_epi16(zero, y_dist));
+	__m128i x_dist = _mm_sub_epi16(_mm_add_epi16(kfile, kfile), seven);
+	x_dist = _mm_max_epi16(x_dist, _mm_sub_epi16(zero, x_dist));
+	__m128i t = _mm_sub_epi16(_mm_set1_epi16(100),
+		_mm_add_epi16(_mm_mullo_epi16(x_dist, x_dist), _mm_mullo_epi16(y_dist, y_dist)));
+	__m128i dist_factor = _mm_add_epi16(_mm_srai_epi16(_mm_mullo_epi16(t, t), 1),
+		_mm_set1_epi16(2000));
+	__m128i edge = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi16(krank, zero), _mm_cmpeq_epi16(krank, seven)),
+		_mm_or_si128(_mm_cmpeq_epi16(kfile, zero), _mm_cmpeq_epi16(kfile, seven)));
+	dist_factor = _mm_sub_epi16(dist_factor, _mm_and_si128(edge, _mm_set1_epi16(500)));
+
+	//blocked by the rook one rank below
+	__m128i blocked = _mm_and_si128(_mm_cmpgt_epi16(krank, _mm_set1_epi16(3)),
+		_mm_cmpeq_epi16(Rrank, _mm_sub_epi16(krank, one)));
+	__m128i K_below = _mm_cmpeq_epi16(Krank, _mm_sub_epi16(krank, two));
+	__m128i trap = _mm_and_si128(K_below, _mm_cmpeq_epi16(kfile, Kfile));
+	__m128i R_adj = _mm_or_si128(_mm_cmpeq_epi16(Rfile, _mm_add_epi16(kfile, one)),
+		_mm_cmpeq_epi16(Rfile, _mm_sub_epi16(kfile, one)));
+	__m128i fd = _mm_sub_epi16(kfile, Rfile);
+	fd = _mm_max_epi16(fd, _mm_sub_epi16(zero, fd));
+	__m128i R_toward = _mm_mullo_epi16(_mm_sub_epi16(seven, fd), _mm_set1_epi16(150));
+	__m128i K_toward = select_epi16(_mm_cmpgt_epi16(Rrank, Krank),
+		_mm_andnot_si128(K_below, _mm_set1_epi16(250)), _mm_set1_epi16(500));
+	__m128i R_trap = select_epi16(R_adj, _mm_set1_epi16(500), _mm_set1_epi16(-1000));
+	__m128i K_trap = _mm_andnot_si128(R_adj, _mm_set1_epi16(-1000));
+	__m128i R_blocked = select_epi16(trap, R_trap, R_toward);
+	__m128i K_blocked = select_epi16(trap, K_trap, K_toward);
+
+	//otherwise: on the rook's line, above it, or below it
+	__m128i on_line = _mm_or_si128(_mm_cmpeq_epi16(Rrank, krank), _mm_cmpeq_epi16(Rfile, kfile));
+	__m128i R_other = select_epi16(on_line, _mm_set1_epi16(100),
+		select_epi16(_mm_cmpgt_epi16(Rrank, krank), _mm_set1_epi16(800), _mm_set1_epi16(600)));
+	__m128i R_factor = select_epi16(blocked, R_blocked, R_other);
+	__m128i K_factor = _mm_and_si128(blocked, K_blocked);
+
+	short h[8];
+	_mm_storeu_si128((__m128i*)h, _mm_add_epi16(dist_factor, _mm_add_epi16(R_factor, K_factor)));
+	for (int i=0; i < n; i++) {
+		out[i] = h[i];
+	}
+#else
+	for (int i=0; i < n; i++) {
+		out[i] = heuristicY_live(boards[i]);
+	}
+#endif
+}
+
+
+/* heuristicX() of the board after each of X's moves
+Input:	state s - the board, X to move
+		MoveList moves - X's moves from s
+		int* out - gets heuristicX(make_move(s, moves[i], true)) for each i
+*/
+void heuristicX_batch(state s, const MoveList& moves, int* out) {
+	int n = moves.size();
+	if (PROFILE_SEARCH) {
+		search_stats.heuristic_calls += n;
+	}
+	if (heuristic_tables_ready) {
+		for (int i=0; i < n; i++) {
+			int K = s.K, R = s.R;
+			if (moves[i] < 64) {
+				K = moves[i];
+			} else {
+				R = moves[i] - 64;
+			}
+			out[i] = hX_table[(K*64 + R)*64 + s.k];
+		}
+		return;
+	}
+	state boards[MAX_MOVES];
+	for (int i=0; i < n; i++) {
+		boards[i] = make_move(s, moves[i], true);
+	}
+	heuristicX_lanes(boards, n, out);
+}
+
+
+/* heuristicX_live() of up to MAX_MOVES boards at once (see the top of the file)
+Input:	boards, n - the boards, none with the rook taken
+		int* out - gets the n values
+*/
+void heuristicX_lanes(const state* boards, int n, int* out) {
+	if (!use_avx2()) {
+		for (int i=0; i < n; i++) {
+			out[i] = score_x(orient_x(boards[i]));
+		}
+		return;
+	}
+#ifdef HX_AVX2
+	x_lanes l;
+	int padded = (n + 7) & ~7;
+	for (int i=0; i < padded; i++) {
+		x_board b = {0, 0, 0, 0, 0, 0, 0};
+		if (i < n) {
+			b = orient_x(boards[i]);
+		}
+		l.dir[i] = b.dir;
+		l.Krank[i] = b.Krank;
+		l.Kfile[i] = b.Kfile;
+		l.Rrank[i] = b.Rrank;
+		l.Rfile[i] = b.Rfile;
+		l.krank[i] = b.krank;
+		l.kfile[i] = b.kfile;
+	}
+	int h[MAX_MOVES];
+	for (int i=0; i < padded; i += 8) {
+		score_x_avx2(l, i, h + i);
+	}
+	for (int i=0; i < n; i++) {
+		out[i] = h[i];
+	}
+#endif
+}
 
 
 /* Heuristic for player X
@@ -27,8 +385,16 @@ Output:	int - the value of the board for player Y
 			Bad positions should return a relatively low number
 			and good positions should return a high number.
 */
-int heuristicX(state s) {
-	int h = 0;
+int heuristicX_live(state s) {
+	return score_x(orient_x(s));
+}
+
+
+/* The first half of heuristicX_live()
+Input:	state s - current state of the board
+Output:	x_board - s turned to push k up (or up and right), in ranks and files
+*/
+static x_board orient_x(state s) {
 	int dir = get_push_dir(s);
 	//orient fixes dir and points up or UR (or none)
 	s = orient(s, dir);
@@ -63,6 +429,24 @@ int heuristicX(state s) {
 		}
 		//dir = UP;
 	}
+	x_board b = {dir, Krank, Kfile, Rrank, Rfile, krank, kfile};
+	return b;
+}
+
+
+/* The second half of heuristicX_live()
+Input:	x_board b - a board from orient_x()
+Output:	int - the value of the board for player X
+*/
+static int score_x(x_board b) {
+	int h = 0;
+	int dir = b.dir;
+	unsigned char Krank = b.Krank;
+	unsigned char Rrank = b.Rrank;
+	unsigned char krank = b.krank;
+	unsigned char Kfile = b.Kfile;
+	unsigned char Rfile = b.Rfile;
+	unsigned char kfile = b.kfile;
 
 	//R should be 1 rank or file from k, and far from k on that row
 	//and the optimal row forces k outside most...
@@ -78,11 +462,9 @@ int heuristicX(state s) {
 	int fdk = (kfile - Kfile)*3;
 
 	//If k can capture R, return 0. If checkmate, return 2^16
-	if ((rd == -1 || rd == 0 || rd == 1) &&
-		(fd == -1 || fd == 0 || fd == 1)) {
+	if (DISTANCE[kfile*8 + krank][Rfile*8 + Rrank] <= 1) {
 		//Unless K adj to R... (protected check)
-		if ((Kfile == Rfile-1 || Kfile == Rfile || Kfile == Rfile+1) &&
-			(Krank == Rrank-1 || Krank == Rrank || Krank == Rrank+1)) {
+		if (DISTANCE[Kfile*8 + Krank][Rfile*8 + Rrank] <= 1) {
 			//find dist to K target...
 			int r_target = krank;
 			int f_target = kfile;
@@ -218,6 +600,133 @@ int heuristicX(state s) {
 }
 
 
+#ifdef HX_AVX2
+//Shorthands for score_x_avx2()
+#define V(x) _mm256_set1_epi32(x)
+#define EQ(a, b) _mm256_cmpeq_epi32(a, b)
+#define GT(a, b) _mm256_cmpgt_epi32(a, b)
+#define AND(a, b) _mm256_and_si256(a, b)
+#define OR(a, b) _mm256_or_si256(a, b)
+#define AND_NOT(m, a) _mm256_andnot_si256(m, a)
+#define ADD(a, b) _mm256_add_epi32(a, b)
+#define SUB(a, b) _mm256_sub_epi32(a, b)
+#define MUL(a, b) _mm256_mullo_epi32(a, b)
+#define ABS(a) _mm256_abs_epi32(a)
+#define SEL(m, a, b) _mm256_blendv_epi8(b, a, m)
+
+/* score_x() of 8 boards (see the top of the file)
+Input:	x_lanes l, int first - boards first to first+7
+		int* out - gets the 8 values
+*/
+__attribute__((target("avx2")))
+static void score_x_avx2(const x_lanes& l, int first, int* out) {
+	__m256i dir = _mm256_loadu_si256((const __m256i*)(l.dir + first));
+	__m256i Krank = _mm256_loadu_si256((const __m256i*)(l.Krank + first));
+	__m256i Kfile = _mm256_loadu_si256((const __m256i*)(l.Kfile + first));
+	__m256i Rrank = _mm256_loadu_si256((const __m256i*)(l.Rrank + first));
+	__m256i Rfile = _mm256_loadu_si256((const __m256i*)(l.Rfile + first));
+	__m256i krank = _mm256_loadu_si256((const __m256i*)(l.krank + first));
+	__m256i kfile = _mm256_loadu_si256((const __m256i*)(l.kfile + first));
+	__m256i rd = SUB(krank, Rrank);
+	__m256i fd = SUB(kfile, Rfile);
+	__m256i rdk = MUL(SUB(SUB(krank, Krank), V(2)), V(3));
+	__m256i fdk = MUL(SUB(kfile, Kfile), V(3));
+
+	//k next to R: 0, unless K protects R
+	__m256i k_adj = GT(V(2), _mm256_max_epi32(ABS(fd), ABS(rd)));
+	__m256i K_adj = GT(V(2), _mm256_max_epi32(ABS(SUB(Kfile, Rfile)), ABS(SUB(Krank, Rrank))));
+	__m256i lost = AND_NOT(K_adj, k_adj);
+	__m256i prot_UR = SUB(V(7), ADD(ABS(SUB(Krank, krank)), ABS(SUB(Kfile, kfile))));
+	prot_UR = MUL(prot_UR, prot_UR);
+	__m256i prot_UP = SEL(GT(Rfile, kfile),
+		ADD(MUL(SUB(V(7), Rfile), V(5)), MUL(SUB(Rfile, Kfile), V(10))),
+		ADD(MUL(Rfile, V(5)), MUL(SUB(Kfile, Rfile), V(10))));
+	__m256i prot_factor = SEL(EQ(dir, V(UR)), prot_UR, AND(EQ(dir, V(UP)), prot_UP));
+	prot_factor = AND(AND(k_adj, K_adj), prot_factor);
+
+	//checkmate and forcing k to the edge
+	__m256i on_rank = AND(EQ(Rrank, krank), EQ(Kfile, kfile));
+	__m256i on_file = AND(EQ(Rfile, kfile), EQ(Krank, krank));
+	__m256i mate = OR(
+		OR(AND(on_rank, AND(EQ(Rrank, V(0)), EQ(Krank, V(2)))),
+			AND(on_rank, AND(EQ(Rrank, V(7)), EQ(Krank, V(5))))),
+		OR(AND(on_file, AND(EQ(Rfile, V(0)), EQ(Kfile, V(2)))),
+			AND(on_file, AND(EQ(Rfile, V(7)), EQ(Kfile, V(5))))));
+	mate = AND_NOT(k_adj, mate);
+	__m256i force = OR(
+		OR(AND(on_rank, AND(GT(Rrank, V(3)), EQ(Krank, SUB(krank, V(2))))),
+			AND(on_rank, AND(GT(V(4), Rrank), EQ(Krank, ADD(krank, V(2)))))),
+		OR(AND(on_file, AND(GT(Rfile, V(3)), EQ(Kfile, SUB(kfile, V(2))))),
+			AND(on_file, AND(GT(V(4), Rfile), EQ(Kfile, ADD(kfile, V(2)))))));
+	force = AND_NOT(OR(k_adj, mate), force);
+
+	__m256i R_above = GT(Rrank, krank);
+	__m256i R_level = EQ(Rrank, krank);
+	__m256i R_below = EQ(Rrank, SUB(krank, V(1)));
+	__m256i R_edge = OR(EQ(Rfile, V(0)), EQ(Rfile, V(7)));
+	__m256i K_in_way = OR(AND(GT(Kfile, kfile), GT(Rfile, Kfile)),
+		AND(GT(kfile, Kfile), GT(Kfile, Rfile)));
+	__m256i K_above_R = GT(Krank, Rrank);
+	__m256i K_level_R = EQ(Krank, Rrank);
+
+	//rook one rank below k
+	__m256i K_behind = AND(OR(
+		AND(AND(GT(Kfile, Rfile), AND_NOT(GT(Kfile, kfile), V(-1))), GT(SUB(kfile, Rfile), V(2))),
+		AND(AND(GT(Rfile, Kfile), AND_NOT(GT(kfile, Kfile), V(-1))), GT(SUB(Rfile, kfile), V(2)))),
+		MUL(V(30), Krank));
+	__m256i K_opposed = AND(AND(EQ(Kfile, kfile), EQ(Krank, SUB(krank, V(2)))), V(45));
+	__m256i K_below = SEL(K_above_R, SUB(MUL(SUB(V(7), Krank), V(150)), V(300)),
+		SEL(K_level_R, SEL(K_in_way, MUL(Krank, V(-400)), V(800)),
+			SUB(ADD(V(1000), K_behind), K_opposed)));
+	__m256i R_below_factor = ADD(MUL(V(1000), Rrank), MUL(MUL(fd, fd), V(2)));
+	__m256i edge_below = AND(R_edge, V(55));
+
+	//rook further below k
+	__m256i K_far = SEL(GT(Krank, krank), SUB(MUL(SUB(V(8), Krank), V(150)), V(200)),
+		SEL(EQ(Krank, krank), MUL(Krank, V(30)),
+			SEL(K_above_R, MUL(Krank, V(40)),
+				SEL(K_level_R, SEL(K_in_way, MUL(Krank, V(-30)), MUL(Krank, V(75))),
+					MUL(Krank, V(150))))));
+	__m256i R_far_factor = ADD(MUL(V(1000), Rrank), MUL(MUL(fd, fd), V(5)));
+	__m256i edge_far = AND(AND(AND(EQ(Rrank, SUB(krank, V(2))), K_above_R),
+		OR(EQ(Rfile, SUB(kfile, V(1))), EQ(Rfile, ADD(kfile, V(1))))), V(-1001));
+
+	__m256i R_factor = SEL(R_below, R_below_factor, R_far_factor);
+	R_factor = AND_NOT(R_above, SEL(R_level, V(1000), R_factor));
+	__m256i K_factor = SEL(R_below, K_below, K_far);
+	K_factor = AND_NOT(OR(R_above, R_level), K_factor);
+	__m256i edge_above = AND(R_edge, ADD(V(250), ADD(MUL(rd, rd), MUL(fd, fd))));
+	__m256i R_on_edge_factor = SEL(R_below, edge_below, edge_far);
+	R_on_edge_factor = AND_NOT(R_level, SEL(R_above, edge_above, R_on_edge_factor));
+
+	//K toward k, with the rook on an edge pulling it to that side
+	fdk = ADD(fdk, AND(EQ(Rfile, V(0)), GT(kfile, V(3))));
+	fdk = SUB(fdk, AND(EQ(Rfile, V(7)), GT(V(4), kfile)));
+	__m256i rdk_factor = SUB(V(21), ABS(rdk));
+	__m256i fdk_factor = SUB(V(15), ABS(fdk));
+	K_factor = ADD(K_factor, ADD(MUL(rdk_factor, rdk_factor), MUL(fdk_factor, fdk_factor)));
+
+	__m256i h = ADD(ADD(R_factor, K_factor), ADD(R_on_edge_factor, prot_factor));
+	h = SEL(force, V(32768), h);
+	h = SEL(mate, V(65536), h);
+	h = AND_NOT(lost, h);
+	_mm256_storeu_si256((__m256i*)out, h);
+}
+
+#undef V
+#undef EQ
+#undef GT
+#undef AND
+#undef OR
+#undef AND_NOT
+#undef ADD
+#undef SUB
+#undef MUL
+#undef ABS
+#undef SEL
+#endif
+
+
 /* Third attempt at Heuristic for player Y
 Input:	state s - current state of the board
 Output:	int - the value of the board for player Y
@@ -237,7 +746,7 @@ Get these derived to about-
 -checkmate conditions: 0
 
 */
-int heuristicY(state s) {
+int heuristicY_live(state s) {
 	//Always capture rook if possible:
 	if (s.R == 255) {
 		return 65536;
@@ -605,18 +1114,13 @@ int heuristicY_old(state s) {
 }
 
 
-/* Finds the direction of the king, the rook tries to trap to one side.
-Return directions are defined in enum:
-	0 = No push direction
-	1=up, 2=down, 3=left, 4=right
-	5=UL, 6=UR, 7=DL, 8=DR
-*/
-int get_push_dir(state s) {
+/* get_push_dir() for k and R, used to build ORIENT.push_dir */
+static constexpr int push_dir_x(int k, int R) {
 	int dir = NONE;
-	unsigned char krank = s.k % 8;
-	unsigned char kfile = s.k / 8;
-	unsigned char Rrank = s.R % 8;
-	unsigned char Rfile = s.R / 8;
+	unsigned char krank = k % 8;
+	unsigned char kfile = k / 8;
+	unsigned char Rrank = R % 8;
+	unsigned char Rfile = R / 8;
 
 	if (krank == kfile) {
 		if (krank < 4) {
@@ -715,93 +1219,14 @@ int get_push_dir(state s) {
 }
 
 
-/* a failed attempt to simplify push_dir */
-int get_push_dir_simple(state s) {
-	int dir = NONE;
-	unsigned char krank = s.k % 8;
-	unsigned char kfile = s.k / 8;
-	if (krank == kfile) {
-		if (krank < 4) {
-			dir = DL;
-		} else {
-			dir = UR;
-		}
-	} else if (7-krank == kfile) {
-		if (krank < 4) {
-			dir = DR;
-		} else {
-			dir = UL;
-		}
-	} else if (krank > kfile) {
-		if (krank > 7-kfile) {
-			dir = UP;
-		} else {
-			dir = LEFT;
-		}
-	} else {
-		if (krank > 7-kfile) {
-			dir = RIGHT;
-		} else {
-			dir = DOWN;
-		}
-	}
-	return dir;
-}
-
-
-/* Reorients the board so that the push direction is UP
-Also sets diagonal k to k on the upper-right diag.
-This is called in the heuristic functions to simplify state.
-*/
-state orient(state s, int& dir) {
-	if (dir == UP || dir == UR || dir == NONE) {
-		return s;
-	}
-	switch (dir) {
-		case DOWN:
-		case DL:
-			s.k = (7 - s.k%8) + (7 - s.k/8)*8;
-			s.K = (7 - s.K%8) + (7 - s.K/8)*8;
-			s.R = (7 - s.R%8) + (7 - s.R/8)*8;
-			break;
-		case LEFT:
-		case UL:
-			s.k = (7 - s.k/8) + (s.k%8)*8;
-			s.K = (7 - s.K/8) + (s.K%8)*8;
-			s.R = (7 - s.R/8) + (s.R%8)*8;
-			break;
-		case RIGHT:
-		case DR:
-			s.k = (s.k/8) + (7-s.k%8)*8;
-			s.K = (s.K/8) + (7-s.K%8)*8;
-			s.R = (s.R/8) + (7-s.R%8)*8;
-			break;
-		default:
-			err("oops.");
-	}
-	if (dir == DOWN || dir == LEFT || dir == RIGHT) {
-		dir = UP;
-	} else {
-		dir = UR;
-	}
-	return s;
-}
-
-
-/* Orient the board for plyaer Y heuristic
-Goal is to push down and center.
-If Rook is forcing k, return s such that krank = Rrank+1
-Else, return s such that k in quadrant 1.
-dir is the direction k is from center
-	ex: k above middle == UP
-*/
-state dir_and_orientY(state s) {
+/* The direction dir_and_orientY() turns the board for k and R */
+static constexpr int orient_dir_y(int k, int R) {
 	//find out where k is, where R is...
 	int dir = NONE;
-	unsigned char krank = s.k % 8;
-	unsigned char kfile = s.k / 8;
-	unsigned char Rrank = s.R % 8;
-	unsigned char Rfile = s.R / 8;
+	unsigned char krank = k % 8;
+	unsigned char kfile = k / 8;
+	unsigned char Rrank = R % 8;
+	unsigned char Rfile = R / 8;
 
 	if (krank == kfile) {
 		if (krank < 4) {
@@ -876,31 +1301,140 @@ state dir_and_orientY(state s) {
 		}
 	}
 
-	//Rotate the board so k is on top
-	switch (dir) {
-		case DOWN:
-		case DL:
-			//rotate 180
-			s.k = (7 - s.k%8) + (7 - s.k/8)*8;
-			s.K = (7 - s.K%8) + (7 - s.K/8)*8;
-			s.R = (7 - s.R%8) + (7 - s.R/8)*8;
-			break;
-		case LEFT:
-		case UL:
-			//rotate 90 clockwise
-			s.k = (7 - s.k/8) + (s.k%8)*8;
-			s.K = (7 - s.K/8) + (s.K%8)*8;
-			s.R = (7 - s.R/8) + (s.R%8)*8;
-			break;
-		case RIGHT:
-		case DR:
-			//rotate 90 cc
-			s.k = (s.k/8) + (7-s.k%8)*8;
-			s.K = (s.K/8) + (7-s.K%8)*8;
-			s.R = (s.R/8) + (7-s.R%8)*8;
-			break;
-		default:
-			break;
+	return dir;
+}
+
+
+/* The SYMMETRY that turns the board for each DIR,
+	so the push direction ends up UP (or UR on a diagonal).
+*/
+static constexpr int DIR_SYMMETRY[9] = {
+	0,	//NONE
+	0,	//UP
+	3,	//DOWN - rotate 180
+	5,	//LEFT - rotate 90 clockwise
+	6,	//RIGHT - rotate 90 cc
+	5,	//UL
+	0,	//UR
+	3,	//DL
+	6	//DR
+};
+
+/* Orientation by [k][R], built at compile time
+push_dir - get_push_dir()
+y_symmetry - the SYMMETRY dir_and_orientY() uses
+*/
+struct orient_tables {
+	unsigned char push_dir[64][64];
+	unsigned char y_symmetry[64][64];
+};
+
+static constexpr orient_tables make_orient_tables() {
+	orient_tables t = {};
+	for (int k=0; k < 64; k++) {
+		for (int R=0; R < 64; R++) {
+			t.push_dir[k][R] = (unsigned char)push_dir_x(k, R);
+			t.y_symmetry[k][R] = (unsigned char)DIR_SYMMETRY[orient_dir_y(k, R)];
+		}
+	}
+	return t;
+}
+
+static constexpr orient_tables ORIENT = make_orient_tables();
+
+
+/* Finds the direction of the king, the rook tries to trap to one side.
+Return directions are defined in enum:
+	0 = No push direction
+	1=up, 2=down, 3=left, 4=right
+	5=UL, 6=UR, 7=DL, 8=DR
+It only depends on k and R, so it is a table lookup (see ORIENT).
+*/
+int get_push_dir(state s) {
+	if (s.R > 63) {
+		return push_dir_x(s.k, s.R);
+	}
+	return ORIENT.push_dir[s.k][s.R];
+}
+
+
+/* a failed attempt to simplify push_dir */
+int get_push_dir_simple(state s) {
+	int dir = NONE;
+	unsigned char krank = s.k % 8;
+	unsigned char kfile = s.k / 8;
+	if (krank == kfile) {
+		if (krank < 4) {
+			dir = DL;
+		} else {
+			dir = UR;
+		}
+	} else if (7-krank == kfile) {
+		if (krank < 4) {
+			dir = DR;
+		} else {
+			dir = UL;
+		}
+	} else if (krank > kfile) {
+		if (krank > 7-kfile) {
+			dir = UP;
+		} else {
+			dir = LEFT;
+		}
+	} else {
+		if (krank > 7-kfile) {
+			dir = RIGHT;
+		} else {
+			dir = DOWN;
+		}
+	}
+	return dir;
+}
+
+
+/* Reorients the board so that the push direction is UP
+Also sets diagonal k to k on the upper-right diag.
+This is called in the heuristic functions to simplify state.
+The turn is one SYMMETRY lookup per piece (a taken rook stays taken).
+*/
+state orient(state s, int& dir) {
+	if (dir == UP || dir == UR || dir == NONE) {
+		return s;
+	}
+	if (dir < NONE || dir > DR) {
+		err("oops.");
+	}
+	const unsigned char* sym = SYMMETRY[DIR_SYMMETRY[dir]];
+	s.k = sym[s.k];
+	s.K = sym[s.K];
+	if (s.R < 64) {
+		s.R = sym[s.R];
+	}
+	if (dir == DOWN || dir == LEFT || dir == RIGHT) {
+		dir = UP;
+	} else {
+		dir = UR;
+	}
+	return s;
+}
+
+
+/* Orient the board for plyaer Y heuristic
+Goal is to push down and center.
+If Rook is forcing k, return s such that krank = Rrank+1
+Else, return s such that k in quadrant 1.
+dir is the direction k is from center
+	ex: k above middle == UP
+The direction only depends on k and R, so it comes from ORIENT.y_symmetry
+	and the turn is one SYMMETRY lookup per piece.
+*/
+state dir_and_orientY(state s) {
+	int t = (s.R > 63) ? DIR_SYMMETRY[orient_dir_y(s.k, s.R)] : ORIENT.y_symmetry[s.k][s.R];
+	const unsigned char* sym = SYMMETRY[t];
+	s.k = sym[s.k];
+	s.K = sym[s.K];
+	if (s.R < 64) {
+		s.R = sym[s.R];
 	}
 	return s;
 }
@@ -5,6 +5,15 @@
 
 int heuristicX(state s);
 int heuristicY(state s);
+int heuristicX_live(state s);
+int heuristicY_live(state s);
+void heuristicX_batch(state s, const MoveList& moves, int* out);
+void heuristicX_lanes(const state* boards, int n, int* out);
+void heuristicY_batch(state s, const MoveList& moves, int* out);
+void heuristicY_lanes(const state* boards, int n, int* out);
+void init_heuristic_tables();
+int verify_heuristic_tables();
+bool heuristic_avx2(bool on);
 int get_push_dir(state s);
 state orient(state s, int& dir);
 state dir_and_orientY(state s);
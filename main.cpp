@@ -56,16 +56,58 @@ $ ./main
 -You will then be prompted with a few questions, and the program will run.
 To simply test the case defined in testCase.txt, run:
 $ ./main <in
+To evaluate many boards without any questions (batch mode), run:
+$ ./main --batch [max_turns] <testCase.txt
+-Each board gets one result line: board, X's best move, moves to mate
+	and the game in PGN. See batch_play() in play.cpp.
+-Anything else (like generating krk.tb) goes to stderr, `make check` tests this.
+The engine for each side and the search depth can be given in either mode:
+$ ./main --x=ex_minimax --y=minimax --depth=3
+$ ./main --x=beam --y=beam --beam=6,3 --depth=2
+-See engine.cpp for the engines. An unknown flag lists them.
 
 */
 
 
 #include <iostream>
+#include <string>
+#include <sstream>
+#include <cctype>
 #include "helper.h"
 #include "play.h"
+#include "engine.h"
+#include "heuristic.h"
+
+
+int main(int argc, char** argv) {
+	EngineConfig cfg = default_engines();
+	bool batch = false;
+	int batch_turns = 35;
+	for (int i=1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (parse_engine_flag(arg, cfg)) {
+			continue;
+		} else if (arg == "--batch") {
+			batch = true;
+			if (i+1 < argc && isdigit(argv[i+1][0])) {
+				std::stringstream(argv[++i]) >> batch_turns;
+			}
+		} else {
+			print_engine_usage();
+			err("Unknown argument " + arg);
+		}
+	}
+	//Maps krk.tb (or builds it on the first run) if an engine uses it.
+	init_engines(cfg);
+	if (HEURISTIC_TABLES) {
+		init_heuristic_tables();
+	}
+	if (batch) {
+		std::ios::sync_with_stdio(false);
+		batch_play(std::cin, std::cout, batch_turns, cfg);
+		return 0;
+	}
 
-
-int main() {
 	//Is this a test?
 	bool is_test = get_is_test();
 	bool x;
@@ -83,10 +125,10 @@ int main() {
 
 	if (is_test) {
 		//Computer runs both sides
-		test_play(s, max_turns);
+		test_play(s, max_turns, cfg);
 	} else {
 		//Competition play
-		play(s, max_turns, !x);
+		play(s, max_turns, !x, cfg);
 	}
 	return 0;
 }
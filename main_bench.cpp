@@ -0,0 +1,401 @@
+/* Micro-benchmarks for move generation, heuristics and search
+Author: Phillip Stewart
+
+Times the building blocks of the AI over a fixed set of boards, so that
+	changes to the heuristics or search can be checked for slowdowns.
+Each benchmark runs its function over the same boards BENCH_REPEATS times
+	and reports the fastest run, which is the least noisy.
+	ns/op - nanoseconds per call
+	pos/sec - boards (calls) per second
+
+The boards are every legal board with X to move (for X functions),
+	and every legal board with Y to move where Y has a move (for Y functions).
+The slower searches only use every n-th board, shown as "1/n".
+The beam search is timed at a few widths and depths, per move and per
+	tree node, to show what each setting costs.
+
+To compile and run:
+$ make bench
+or
+$ ./main_bench [name] [engine flags]
+> runs only the benchmarks whose name contains [name]
+The stripped_test_play sweep plays the engines given by the flags
+	(see engine.cpp), so every engine pairing can be timed from one binary.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "helper.h"
+#include "heuristic.h"
+#include "move.h"
+#include "play.h"
+#include "tablebase.h"
+#include "engine.h"
+#include "beam.h"
+using namespace std;
+using namespace std::chrono;
+
+
+#define BENCH_REPEATS 5
+
+
+/* Functions specific to this module */
+void find_bench_states();
+void bench(string name, const vector<state>& states, int step, long (*fn)(state), void (*setup)() = NULL);
+void bench_alphabeta(int step);
+void bench_beam(bool player_x, int x_beam, int y_beam, int depth, int step);
+long b_list_x(state s);
+long b_list_y(state s);
+long b_y_in_check(state s);
+long b_in_checkmate(state s);
+long b_heuristicX(state s);
+long b_heuristicY(state s);
+long b_heuristicX_live(state s);
+long b_heuristicY_live(state s);
+long b_replies_live(state s);
+long b_replies_lanes(state s);
+long b_replies_batch(state s);
+long b_x_moves_live(state s);
+long b_x_moves_lanes(state s);
+long b_x_moves_batch(state s);
+long b_moveX(state s);
+long b_moveY(state s);
+long b_ex_minimax_moveX(state s);
+long b_maximax_moveX(state s);
+long b_minimax_moveY(state s);
+long b_additive_minimax_moveY(state s);
+long b_tablebase_moveX(state s);
+long b_tablebase_moveY(state s);
+long b_stripped_test_play(state s);
+void clear_sweep_tt();
+
+
+vector<state> x_states;
+vector<state> y_states;
+string filter;
+TransTable* sweep_tt;
+EngineConfig sweep_cfg;
+//results are added here so the compiler can't skip the calls.
+volatile long sink;
+
+
+/* Collects the boards the benchmarks run over. */
+void find_bench_states() {
+	for (int i=0; i < 64*64*64; i++) {
+		state s(i/4096, (i/64)%64, i%64);
+		if (!s.is_valid() || kings_too_close(s)) {
+			continue;
+		}
+		if (!y_in_check(s)) {
+			x_states.push_back(s);
+		}
+		if (list_all_moves_y(s).size() > 0) {
+			y_states.push_back(s);
+		}
+	}
+}
+
+
+/* Times fn over every step-th board and prints the fastest run.
+setup, if given, is called before each run and not timed.
+*/
+void bench(string name, const vector<state>& states, int step, long (*fn)(state), void (*setup)()) {
+	if (name.find(filter) == string::npos) {
+		return;
+	}
+	double best = 0.0;
+	long ops = 0;
+	for (int r=0; r < BENCH_REPEATS; r++) {
+		long total = 0;
+		ops = 0;
+		if (setup) {
+			setup();
+		}
+		steady_clock::time_point start = steady_clock::now();
+		for (int i=0; i < (int)states.size(); i += step) {
+			total += fn(states[i]);
+			ops++;
+		}
+		double secs = duration<double>(steady_clock::now() - start).count();
+		sink = total;
+		if (r == 0 || secs < best) {
+			best = secs;
+		}
+	}
+	stringstream label;
+	label << name;
+	if (step > 1) {
+		label << " (1/" << step << ")";
+	}
+	cout << left << setw(34) << label.str()
+		<< right << setw(12) << fixed << setprecision(1) << best * 1e9 / ops << " ns/op"
+		<< setw(14) << setprecision(0) << ops / best << " pos/sec\n";
+}
+
+
+/* alphabeta_moveX() always uses its whole time budget,
+	so report how many nodes it searches per second instead.
+*/
+void bench_alphabeta(int step) {
+	string name = "alphabeta_moveX";
+	if (name.find(filter) == string::npos) {
+		return;
+	}
+	TransTable tt;
+	long nodes = 0;
+	steady_clock::time_point start = steady_clock::now();
+	for (int i=0; i < (int)x_states.size(); i += step) {
+		SearchContext ctx;
+		ctx.tt = &tt;
+		sink = alphabeta_moveX(x_states[i], ctx);
+		nodes += ctx.nodes;
+	}
+	double secs = duration<double>(steady_clock::now() - start).count();
+	stringstream label;
+	label << name << " (1/" << step << ")";
+	cout << left << setw(34) << label.str()
+		<< right << setw(12) << fixed << setprecision(0) << nodes / secs << " nodes/sec\n";
+}
+
+
+/* Times beam_moveX() or beam_moveY() at one setting, per move and per node */
+void bench_beam(bool player_x, int x_beam, int y_beam, int depth, int step) {
+	stringstream label;
+	label << (player_x ? "beam_moveX " : "beam_moveY ") << x_beam << "," << y_beam
+		<< " d" << depth << " (1/" << step << ")";
+	if (label.str().find(filter) == string::npos) {
+		return;
+	}
+	const vector<state>& states = player_x ? x_states : y_states;
+	long nodes = 0;
+	long moves = 0;
+	steady_clock::time_point start = steady_clock::now();
+	for (int i=0; i < (int)states.size(); i += step) {
+		SearchContext ctx;
+		ctx.x_beam = x_beam;
+		ctx.y_beam = y_beam;
+		ctx.depth = depth;
+		sink = player_x ? beam_moveX(states[i], ctx) : beam_moveY(states[i], ctx);
+		nodes += ctx.nodes;
+		moves++;
+	}
+	double secs = duration<double>(steady_clock::now() - start).count();
+	cout << left << setw(34) << label.str()
+		<< right << setw(12) << fixed << setprecision(1) << secs * 1e9 / moves << " ns/op"
+		<< setw(14) << setprecision(0) << nodes / secs << " nodes/sec\n";
+}
+
+
+long b_list_x(state s) {
+	return list_all_moves_x(s).size();
+}
+
+long b_list_y(state s) {
+	return list_all_moves_y(s).size();
+}
+
+long b_y_in_check(state s) {
+	return y_in_check(s);
+}
+
+long b_in_checkmate(state s) {
+	return in_checkmate(s);
+}
+
+long b_heuristicX(state s) {
+	return heuristicX(s);
+}
+
+long b_heuristicY(state s) {
+	return heuristicY(s);
+}
+
+long b_heuristicX_live(state s) {
+	return heuristicX_live(s);
+}
+
+long b_heuristicY_live(state s) {
+	return heuristicY_live(s);
+}
+
+//heuristicX of each X move: one at a time, AVX2 lanes, and from the table
+long b_x_moves_live(state s) {
+	MoveList moves = list_all_moves_x(s);
+	long total = 0;
+	for (int i=0; i < (int)moves.size(); i++) {
+		total += heuristicX_live(make_move(s, moves[i], true));
+	}
+	return total;
+}
+
+long b_x_moves_lanes(state s) {
+	MoveList moves = list_all_moves_x(s);
+	state boards[MAX_MOVES];
+	int out[MAX_MOVES];
+	long total = 0;
+	int n = moves.size();
+	for (int i=0; i < n; i++) {
+		boards[i] = make_move(s, moves[i], true);
+	}
+	heuristicX_lanes(boards, n, out);
+	for (int i=0; i < n; i++) {
+		total += out[i];
+	}
+	return total;
+}
+
+long b_x_moves_batch(state s) {
+	MoveList moves = list_all_moves_x(s);
+	int out[MAX_MOVES];
+	long total = 0;
+	heuristicX_batch(s, moves, out);
+	for (int i=0; i < (int)moves.size(); i++) {
+		total += out[i];
+	}
+	return total;
+}
+
+//heuristicY of each Y reply: one at a time, 8 lanes, and from the table
+long b_replies_live(state s) {
+	MoveList moves = list_all_moves_y(s);
+	long total = 0;
+	for (int i=0; i < (int)moves.size(); i++) {
+		total += heuristicY_live(make_move(s, moves[i], false));
+	}
+	return total;
+}
+
+long b_replies_lanes(state s) {
+	MoveList moves = list_all_moves_y(s);
+	state boards[8];
+	int out[8];
+	long total = 0;
+	int n = moves.size();
+	for (int i=0; i < n; i++) {
+		boards[i] = make_move(s, moves[i], false);
+	}
+	heuristicY_lanes(boards, n, out);
+	for (int i=0; i < n; i++) {
+		total += out[i];
+	}
+	return total;
+}
+
+long b_replies_batch(state s) {
+	MoveList moves = list_all_moves_y(s);
+	int out[MAX_MOVES];
+	long total = 0;
+	heuristicY_batch(s, moves, out);
+	for (int i=0; i < (int)moves.size(); i++) {
+		total += out[i];
+	}
+	return total;
+}
+
+long b_moveX(state s) {
+	SearchContext ctx;
+	return moveX(s, ctx);
+}
+
+long b_moveY(state s) {
+	return moveY(s);
+}
+
+long b_ex_minimax_moveX(state s) {
+	SearchContext ctx;
+	return ex_minimax_moveX(s, DEPTH, ctx);
+}
+
+long b_maximax_moveX(state s) {
+	SearchContext ctx;
+	return maximax_moveX(s, DEPTH, ctx);
+}
+
+long b_minimax_moveY(state s) {
+	SearchContext ctx;
+	return minimax_moveY(s, DEPTH, ctx);
+}
+
+long b_additive_minimax_moveY(state s) {
+	SearchContext ctx;
+	return additive_minimax_moveY(s, DEPTH, ctx);
+}
+
+long b_tablebase_moveX(state s) {
+	return tablebase_moveX(s);
+}
+
+long b_tablebase_moveY(state s) {
+	return tablebase_moveY(s);
+}
+
+long b_stripped_test_play(state s) {
+	return stripped_test_play(s, 35, sweep_tt, sweep_cfg);
+}
+
+/* Empties the sweep's table, so every run starts cold like a finder pass */
+void clear_sweep_tt() {
+	sweep_tt->clear();
+}
+
+
+/* Runs the benchmarks
+Optional argument: only run benchmarks with this in their name.
+*/
+int main(int argc, char** argv) {
+	sweep_cfg = default_engines();
+	for (int i=1; i < argc; i++) {
+		if (!parse_engine_flag(argv[i], sweep_cfg)) {
+			filter = argv[i];
+		}
+	}
+	tb_init();
+	if (HEURISTIC_TABLES) {
+		init_heuristic_tables();
+	}
+	find_bench_states();
+	cout << x_states.size() << " X boards, " << y_states.size() << " Y boards, best of "
+		<< BENCH_REPEATS << " runs.\n";
+
+	bench("list_all_moves_x", x_states, 1, b_list_x);
+	bench("list_all_moves_y", y_states, 1, b_list_y);
+	bench("y_in_check", y_states, 1, b_y_in_check);
+	bench("in_checkmate", y_states, 1, b_in_checkmate);
+	bench("heuristicX", x_states, 1, b_heuristicX);
+	bench("heuristicY", y_states, 1, b_heuristicY);
+	bench("heuristicX_live", x_states, 1, b_heuristicX_live);
+	bench("heuristicY_live", y_states, 1, b_heuristicY_live);
+	bench("X moves: heuristicX_live", x_states, 1, b_x_moves_live);
+	bench("X moves: heuristicX_lanes", x_states, 1, b_x_moves_lanes);
+	bench("X moves: heuristicX_batch", x_states, 1, b_x_moves_batch);
+	bench("Y replies: heuristicY_live", y_states, 1, b_replies_live);
+	bench("Y replies: heuristicY_lanes", y_states, 1, b_replies_lanes);
+	bench("Y replies: heuristicY_batch", y_states, 1, b_replies_batch);
+	bench("moveX", x_states, 1, b_moveX);
+	bench("moveY", y_states, 1, b_moveY);
+	bench("tablebase_moveX", x_states, 1, b_tablebase_moveX);
+	bench("tablebase_moveY", y_states, 1, b_tablebase_moveY);
+	bench("ex_minimax_moveX", x_states, 16, b_ex_minimax_moveX);
+	bench("maximax_moveX", x_states, 16, b_maximax_moveX);
+	bench("minimax_moveY", y_states, 16, b_minimax_moveY);
+	bench("additive_minimax_moveY", y_states, 16, b_additive_minimax_moveY);
+	bench_alphabeta(20000);
+	bench_beam(true, 3, 2, 1, 16);
+	bench_beam(true, 5, 3, 1, 16);
+	bench_beam(true, 5, 3, 2, 64);
+	bench_beam(true, 8, 4, 2, 256);
+	bench_beam(false, 5, 3, 1, 16);
+	bench_beam(false, 4, 4, 2, 64);
+
+	//one table for the whole sweep, like the finder's workers, emptied
+	//before each run so no run starts with the last one's entries.
+	TransTable tt;
+	sweep_tt = &tt;
+	bench("stripped_test_play sweep", x_states, 4, b_stripped_test_play, clear_sweep_tt);
+	return 0;
+}
@@ -11,11 +11,29 @@ $ make main_find
 $ ./main_find
 > displays the top 32 states from all possible
 $ ./main_find testCases.txt
-> displays results for the states given in the file
-
-By modifying the moveX and moveY calls in the stripped_test_play function,
-	you can quickly test differing search methods for finding moves.
-Also, modifying the defined DEPTH in helper.h will yield different results.
+> displays the rank of every state in the file, in file order
+	(no longer sorted by rank), so for the longest games first:
+$ ./main_find testCases.txt | sort -k2 -rn
+$ ./main_find --tournament[=step]
+> plays every X engine against every Y engine from every step-th legal
+	board and prints mate rate, moves to mate, draws and time per move
+	(see tournament.cpp). --x= or --y= limits that side to one engine.
+$ ./main_find testCases.txt --record=results.krk
+> also writes every board with its result, in file order, as a binary
+	corpus, so two versions of the engines can be compared with cmp
+$ ./main_find --convert in out
+> converts a test case corpus between text and binary (see corpus.cpp)
+$ ./main_find --analyze[=file] --x=greedy
+> compares the moves played from every legal board with the true distance
+	to mate, prints a histogram and writes the worst positions to file
+	(see analysis.cpp).
+
+The engines and search depth are picked with the flags from engine.cpp,
+	so differing search methods can be tested without recompiling:
+$ ./main_find --x=greedy --y=additive --depth=3 [testCases.txt]
+$ ./main_find --x=beam --beam=8,4 --depth=2
+With the default --x=tablebase, X plays perfectly from the tablebase, so
+	the finder reports the true longest mates against Y's search.
 */
 
 
@@ -26,55 +44,49 @@ Also, modifying the defined DEPTH in helper.h will yield different results.
 #include <iomanip>
 #include <vector>
 #include <utility>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <atomic>
 #include "helper.h"
 #include "move.h"
+#include "engine.h"
+#include "tablebase.h"
+#include "heuristic.h"
+#include "profile.h"
 #include "play.h"
+#include "tournament.h"
+#include "analysis.h"
+#include "corpus.h"
 using namespace std;
 
 
+#define TOP_N 32
+
+
+/* A board found by the finder, order is its position in the sweep. */
+struct ranked_board {
+	int turns;
+	long order;
+	state s;
+};
+
+typedef priority_queue<ranked_board, vector<ranked_board>,
+	bool(*)(const ranked_board&, const ranked_board&)> board_heap;
+
+
 /* Functions specific to this module */
-int stripped_test_play(state s, int max_turns);
 void print_state(state s);
 void print_states(vector< pair<int, state> > ranked_boards);
 void save_states_to_file(vector< pair<int, state> > ranked_boards);
-void run_finder();
-vector<state> get_states_from_file(string filename);
-void run_tester(string filename);
-
-
-/* Game controller for tests
-Controls the play of the game. Runs automatically choosing best plays.
-Input:	state s - initial state of the board
-		int max_turns - maximum moves per player allowed.
-*/
-int stripped_test_play(state s, int max_turns) {
-	bool MATE = false;
-	int num_turns = 0;
-	unsigned char move;
-	while (num_turns < max_turns) {
-		//Player X goes first.
-		move = moveX(s);
-		//move = maximax_moveX(s, DEPTH);
-		//move = ex_minimax_moveX(s, DEPTH);
-		s = make_move(s, move, true);
-
-		//move = moveY(s);
-		//move = minimax_moveY(s, DEPTH);
-		move = additive_minimax_moveY(s, DEPTH);
-		
-		if (move == 255) {
-			MATE = true;
-			num_turns++;
-			break;
-		}
-		s = make_move(s, move, false);
-		if (s.R == 255) {
-			break;
-		}
-		num_turns++;
-	}
-	return num_turns;
-}
+void run_finder(const EngineConfig& cfg);
+void finder_worker(atomic<int>* next_task, const EngineConfig* cfg, vector<ranked_board>* top, int* stalemates, SearchStats* stats);
+bool board_ranks_higher(const ranked_board& a, const ranked_board& b);
+void keep_top_board(board_heap& heap, const ranked_board& board);
+void print_top_boards(vector<ranked_board> merged);
+void run_tester(string filename, string record_file, const EngineConfig& cfg);
+void tester_worker(PositionReader* reader, CorpusWriter* recorder, BatchOrder<string>* output, const EngineConfig* cfg, int* stalemates, SearchStats* stats);
+void print_lines(const string& lines);
 
 
 /* Prints a single state to stdout */
@@ -142,69 +154,131 @@ Runs test_play on all possible starting boards.
 	while still testing all variations.
 Before running test_play, checks to see if the board is valid.
 This is very useful for finding problems with the heuristic and search functions.
-It will show the longest running tests (capped at 32 for now)
+It will show the longest running tests (capped at TOP_N for now)
+
+The sweep is split into one task per (K, R) square pair.
+	Every core runs a worker that claims the next unclaimed task, so fast
+	and slow tasks balance out, and keeps its own top TOP_N heap.
+	The heaps are merged once all workers are done.
 */
-void run_finder() {
-	state s;
-	int turns = 0;
-	int lower_bound = 1;
-	vector< pair<int, state> > ranked_boards;
+void run_finder(const EngineConfig& cfg) {
+	atomic<int> next_task(0);
+	int num_threads = thread::hardware_concurrency();
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	vector< vector<ranked_board> > tops(num_threads);
+	vector<int> stalemates(num_threads, 0);
+	vector<SearchStats> stats(num_threads);
+	vector<thread> workers;
+	for (int t=0; t < num_threads; t++) {
+		workers.push_back(thread(finder_worker, &next_task, &cfg, &tops[t], &stalemates[t], &stats[t]));
+	}
+	vector<ranked_board> merged;
+	int total_stalemates = 0;
+	SearchStats total = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+	for (int t=0; t < num_threads; t++) {
+		workers[t].join();
+		merged.insert(merged.end(), tops[t].begin(), tops[t].end());
+		total_stalemates += stalemates[t];
+		add_search_stats(total, stats[t]);
+	}
 
-	for (int i=0; i<64; i++) {
-		for (int j=0; j<64; j++) {
-			for (int k=0; k<28; k++) {
-				s = state(i, j, k);
-				if (k%8 == 4) {
-					k += 4;
-				}
-				if (!s.is_valid()) {
-					continue;
-				} else if (kings_too_close(s) || y_in_check(s)) {
-					continue;
-				}
-				turns = stripped_test_play(s, 35);
-				if (turns > lower_bound) {
-					ranked_boards.push_back(make_pair(turns, s));
-				}
+	print_top_boards(merged);
+	cout << "Stalemated games: " << total_stalemates << endl;
+	if (PROFILE_SEARCH) {
+		print_search_stats("Finder", total);
+	}
+}
+
+
+/* Worker thread for run_finder
+Input:	next_task - shared counter of the next (K, R) pair to test
+		cfg - the engines to play
+		top - filled with this worker's best TOP_N boards when done
+		stalemates - set to the number of this worker's games Y stalemated
+		stats - filled with this worker's search counters when done
+*/
+void finder_worker(atomic<int>* next_task, const EngineConfig* cfg, vector<ranked_board>* top, int* stalemates, SearchStats* stats) {
+	if (PROFILE_SEARCH) {
+		reset_search_stats();
+	}
+	board_heap heap(board_ranks_higher);
+	ranked_board board;
+	TransTable tt;
+	state s;
+	int task, turns;
+	GameRecord record;
+	while ((task = (*next_task)++) < 64*64) {
+		int i = task / 64;
+		int j = task % 64;
+		for (int k=0; k<28; k++) {
+			s = state(i, j, k);
+			board.order = task*64 + k;
+			if (k%8 == 4) {
+				k += 4;
+			}
+			if (!s.is_valid()) {
+				continue;
+			} else if (kings_too_close(s) || y_in_check(s)) {
+				continue;
 			}
-			if (ranked_boards.size() > 32) {
-				sort(ranked_boards.begin(), ranked_boards.end());
-				reverse(ranked_boards.begin(), ranked_boards.end());
-				ranked_boards.resize(32);
-				lower_bound = ranked_boards[31].first;
+			turns = stripped_test_play(s, 35, &tt, *cfg, &record);
+			if (record.outcome == GAME_STALEMATE) {
+				(*stalemates)++;
 			}
+			if (turns <= 1) {
+				continue;
+			}
+			board.turns = turns;
+			board.s = s;
+			keep_top_board(heap, board);
 		}
 	}
+	while (!heap.empty()) {
+		top->push_back(heap.top());
+		heap.pop();
+	}
+	*stats = search_stats;
+}
 
-	sort(ranked_boards.begin(), ranked_boards.end());
-	reverse(ranked_boards.begin(), ranked_boards.end());
-	ranked_boards.resize(32);
 
-	print_states(ranked_boards);
-	//save_states_to_file(ranked_boards);
+/* Ordering for the finder: more turns first, ties go to the earlier board
+	in the sweep, so the result does not depend on thread scheduling.
+*/
+bool board_ranks_higher(const ranked_board& a, const ranked_board& b) {
+	if (a.turns != b.turns) {
+		return a.turns > b.turns;
+	}
+	return a.order < b.order;
 }
 
 
-/* Read states from file and return a vector of states */
-vector<state> get_states_from_file(string filename) {
-	ifstream infile;
-	infile.open(filename);
-	string line;
-	vector<state> states;
-	while (getline(infile, line)) {
-		int a,b,c,d,e,f,good;
-		good = sscanf(line.c_str(),"x.K(%d,%d),x.R(%d,%d),y.K(%d,%d)",&a,&b,&c,&d,&e,&f);
-		if (!good) {break;}
-		char K = (char)((a-1)*8 + (b-1));
-		char R = (char)((c-1)*8 + (d-1));
-		char k = (char)((e-1)*8 + (f-1));
-		state s(K, R, k);
-		if (s.is_valid()) {
-			states.push_back(s);
-		}
+/* Adds board to heap if it is among the top TOP_N seen so far.
+heap.top() is the lowest ranked board kept.
+*/
+void keep_top_board(board_heap& heap, const ranked_board& board) {
+	if ((int)heap.size() < TOP_N) {
+		heap.push(board);
+	} else if (board_ranks_higher(board, heap.top())) {
+		heap.pop();
+		heap.push(board);
 	}
-	infile.close();
-	return states;
+}
+
+
+/* Prints the TOP_N best of the workers' merged boards */
+void print_top_boards(vector<ranked_board> merged) {
+	sort(merged.begin(), merged.end(), board_ranks_higher);
+	if (merged.size() > TOP_N) {
+		merged.resize(TOP_N);
+	}
+	vector< pair<int, state> > ranked_boards;
+	for (int i=0; i < (int)merged.size(); i++) {
+		ranked_boards.push_back(make_pair(merged[i].turns, merged[i].s));
+	}
+	print_states(ranked_boards);
+	//save_states_to_file(ranked_boards);
 }
 
 
@@ -213,29 +287,99 @@ Similar to run_finder above, but instead of testing all boards,
 	just tests the boards defined in the test case file.
 This is useful when testing problematic starting positions
 	with searching at great depth.
+The file is streamed (see corpus.cpp): workers pull batches of boards
+	from the reader as they go, so memory use doesn't grow with the file
+	and parsing overlaps the games. Every board played gets a rank line,
+	in file order (batches that finish early wait in a BatchOrder, see
+	corpus.h), so pipe through sort -k2 -rn for the longest games first.
+If record_file is given, every board and its result are written there too.
 */
-void run_tester(string filename) {
-	vector<state> states = get_states_from_file(filename);
-	state s;
-	int turns = 0;
-	vector< pair<int, state> > ranked_boards;
+void run_tester(string filename, string record_file, const EngineConfig& cfg) {
+	PositionReader reader;
+	if (!reader.open(filename)) {
+		err("Could not open " + filename);
+	}
+	CorpusWriter recorder;
+	if (!record_file.empty() && !recorder.open(record_file, true, true)) {
+		err("Could not open " + record_file + " for writing.");
+	}
+	int num_threads = thread::hardware_concurrency();
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	BatchOrder<string> output;
+	vector<int> stalemates(num_threads, 0);
+	vector<SearchStats> stats(num_threads);
+	vector<thread> workers;
+	for (int t=0; t < num_threads; t++) {
+		workers.push_back(thread(tester_worker, &reader, record_file.empty() ? NULL : &recorder, &output, &cfg, &stalemates[t], &stats[t]));
+	}
+	int total_stalemates = 0;
+	SearchStats total = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+	for (int t=0; t < num_threads; t++) {
+		workers[t].join();
+		total_stalemates += stalemates[t];
+		add_search_stats(total, stats[t]);
+	}
 
-	for (int i=0; i<(int)states.size(); i++) {
-		s = states[i];
-		if (!s.is_valid()) {
-			continue;
-		} else if (kings_too_close(s) || y_in_check(s)) {
-			continue;
+	if (!record_file.empty() && !recorder.close()) {
+		err("Could not write " + record_file);
+	}
+	cout << "Stalemated games: " << total_stalemates << endl;
+	cerr << reader.positions() << " boards read, " << reader.skipped()
+		<< " lines skipped.\n";
+	if (PROFILE_SEARCH) {
+		print_search_stats("Tester", total);
+	}
+}
+
+
+/* Worker thread for run_tester
+Input:	reader - the test case file, shared by all workers
+		recorder - where each batch's results go, NULL for nowhere
+		output - where each batch's rank lines go
+		the rest as in finder_worker()
+*/
+void tester_worker(PositionReader* reader, CorpusWriter* recorder, BatchOrder<string>* output, const EngineConfig* cfg, int* stalemates, SearchStats* stats) {
+	if (PROFILE_SEARCH) {
+		reset_search_stats();
+	}
+	TransTable tt;
+	GameRecord record;
+	vector<state> batch;
+	vector<unsigned char> results;
+	long first;
+	int turns;
+	while (reader->next_batch(batch, first, READER_BATCH)) {
+		results.assign(batch.size(), CORPUS_NO_RESULT);
+		stringstream lines;
+		for (int i=0; i < (int)batch.size(); i++) {
+			state s = batch[i];
+			if (!s.is_valid()) {
+				continue;
+			} else if (kings_too_close(s) || y_in_check(s)) {
+				continue;
+			}
+			turns = stripped_test_play(s, 35, &tt, *cfg, &record);
+			if (record.outcome == GAME_STALEMATE) {
+				(*stalemates)++;
+			}
+			results[i] = corpus_result(turns, record.outcome);
+			lines << "Rank: " << turns << "\t Board: " << state_to_string(s) << "\n";
 		}
-		turns = stripped_test_play(s, 35);
-		ranked_boards.push_back(make_pair(turns, s));
+		if (recorder) {
+			recorder->write_batch(first, batch, results);
+		}
+		output->add(first, batch.size(), lines.str(), print_lines);
 	}
+	*stats = search_stats;
+}
 
-	sort(ranked_boards.begin(), ranked_boards.end());
-	reverse(ranked_boards.begin(), ranked_boards.end());
 
-	print_states(ranked_boards);
-	//save_states_to_file(ranked_boards);
+/* Prints a batch of the tester's rank lines, called by BatchOrder in file order */
+void print_lines(const string& lines) {
+	cout << lines;
+	cout.flush();
 }
 
 
@@ -243,14 +387,79 @@ void run_tester(string filename) {
 If supplied a command-line argument <testcase.txt>,
 	it will try to run the tests defined there.
 Otherwise, run tests on all states.
+Engine flags (see engine.cpp) may come before or after the file name.
 */
 int main(int argc, char** argv) {
-	if (argc == 1) {
-		run_finder();
+	EngineConfig cfg = default_engines();
+	string filename;
+	bool tournament = false;
+	int step = 1;
+	string analysis_file;
+	string record_file;
+	vector<const Engine*> x_engines = list_engines(true);
+	vector<const Engine*> y_engines = list_engines(false);
+	for (int i=1; i < argc; i++) {
+		string arg = argv[i];
+		if (parse_engine_flag(arg, cfg)) {
+			if (arg.compare(0, 4, "--x=") == 0) {
+				x_engines.assign(1, cfg.x);
+			} else if (arg.compare(0, 4, "--y=") == 0) {
+				y_engines.assign(1, cfg.y);
+			}
+		} else if (arg == "--tournament" || arg.compare(0, 13, "--tournament=") == 0) {
+			tournament = true;
+			if (arg != "--tournament" && (!parse_int(arg.substr(13), step) || step < 1)) {
+				err("Bad tournament step in " + arg);
+			}
+		} else if (arg == "--analyze") {
+			analysis_file = ANALYSIS_FILE;
+		} else if (arg.compare(0, 10, "--analyze=") == 0) {
+			analysis_file = arg.substr(10);
+			if (analysis_file.empty()) {
+				err("No file name in " + arg);
+			}
+		} else if (arg.compare(0, 9, "--record=") == 0) {
+			record_file = arg.substr(9);
+		} else if (arg == "--convert") {
+			if (i + 2 >= argc) {
+				err("Usage: main_find --convert <in> <out>");
+			}
+			if (!convert_corpus(argv[i+1], argv[i+2])) {
+				err(string("Could not convert ") + argv[i+1] + " to " + argv[i+2]);
+			}
+			return 0;
+		} else if (arg.compare(0, 2, "--") == 0) {
+			print_engine_usage();
+			err("Unknown argument " + arg);
+		} else {
+			filename = arg;
+		}
+	}
+	if (HEURISTIC_TABLES) {
+		init_heuristic_tables();
+	}
+	if (tournament) {
+		//Every engine may need the tablebase.
+		tb_init();
+		vector<const Engine*> engines(x_engines);
+		engines.insert(engines.end(), y_engines.begin(), y_engines.end());
+		print_beam_depth(cfg, engines);
+		run_tournament(x_engines, y_engines, cfg, step);
+		return 0;
+	}
+	if (!analysis_file.empty()) {
+		tb_init();
+		init_engines(cfg);
+		run_analysis(cfg, analysis_file);
+		return 0;
+	}
+	init_engines(cfg);
+	cerr << "X: " << cfg.x->name << ", Y: " << cfg.y->name << ", depth " << cfg.depth
+		<< ", beam " << cfg.x_beam << "," << cfg.y_beam << endl;
+	if (filename.empty()) {
+		run_finder(cfg);
 	} else {
-		run_tester(argv[1]);
+		run_tester(filename, record_file, cfg);
 	}
 	return 0;
 }
-
-
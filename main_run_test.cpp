@@ -11,6 +11,11 @@ For example, the test_heuristics() is helpful for seeing the
 
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include <utility>
+#include <algorithm>
 #include "helper.h"
 #include "heuristic.h"
 using namespace std;
@@ -20,11 +25,15 @@ using namespace std;
 void verify_lam(state s);
 void test_heuristics();
 void test_orient(state s);
+int test_heuristic_tables();
+long test_heuristicY_batch();
+long test_heuristicX_batch();
+long run_checks();
 
 
 /* Testing function to verify that list_all_moves() works... */
 void verify_lam(state s) {
-	vector<unsigned char> moves;
+	MoveList moves;
 	int l;
 	cout << "\nPlayer X's moves:\n";
 	moves = list_all_moves_x(s);
@@ -52,11 +61,11 @@ void verify_lam(state s) {
 /* Look at all possible moves from a state and show their value */
 void test_heuristics() {
 	state s = get_state_from_file();
-	vector<unsigned char> moves;
+	MoveList moves;
 	moves = list_all_moves_x(s);
 	unsigned char move;
 	string move_str;
-	vector< pair<int, unsigned char> > ranked_moves;
+	RankedMoves ranked_moves;
 	int i, rank;
 
 	for (i=0; i < (int)moves.size(); i++) {
@@ -105,11 +114,110 @@ void test_orient(state s) {
 }
 
 
-/* Calls test functions... */
-int main() {
+/* Checks the precomputed heuristic tables against the heuristics
+Output:	int - mismatched boards
+*/
+int test_heuristic_tables() {
+	init_heuristic_tables();
+	int bad = verify_heuristic_tables();
+	cout << "Heuristic tables: " << bad << " mismatched boards.\n";
+	return bad;
+}
+
+
+/* Compare heuristicY_batch() to heuristicY_live() on every Y reply of
+	every legal board, with or without the tables (whatever is set up).
+Output:	long - mismatched replies
+*/
+long test_heuristicY_batch() {
+	int ranks[MAX_MOVES];
+	long boards = 0, bad = 0;
+	for (int i=0; i < 64*64*64; i++) {
+		state s(i/4096, (i/64)%64, i%64);
+		if (!s.is_valid() || kings_too_close(s)) {
+			continue;
+		}
+		MoveList moves = list_all_moves_y(s);
+		heuristicY_batch(s, moves, ranks);
+		for (int j=0; j < (int)moves.size(); j++) {
+			if (ranks[j] != heuristicY_live(make_move(s, moves[j], false))) {
+				bad++;
+			}
+		}
+		boards++;
+	}
+	cout << "heuristicY_batch: " << boards << " boards, "
+		<< bad << " mismatched replies.\n";
+	return bad;
+}
+
+
+/* Compare heuristicX_batch() to heuristicX_live() on every X move of
+	every legal board, with or without the tables and AVX2
+	(whatever is set up, see heuristic_avx2()).
+Output:	long - mismatched moves
+*/
+long test_heuristicX_batch() {
+	int ranks[MAX_MOVES];
+	long boards = 0, bad = 0;
+	for (int i=0; i < 64*64*64; i++) {
+		state s(i/4096, (i/64)%64, i%64);
+		if (!s.is_valid() || kings_too_close(s)) {
+			continue;
+		}
+		MoveList moves = list_all_moves_x(s);
+		heuristicX_batch(s, moves, ranks);
+		for (int j=0; j < (int)moves.size(); j++) {
+			if (ranks[j] != heuristicX_live(make_move(s, moves[j], true))) {
+				bad++;
+			}
+		}
+		boards++;
+	}
+	cout << "heuristicX_batch: " << boards << " boards, "
+		<< bad << " mismatched moves.\n";
+	return bad;
+}
+
+
+/* Runs the batch and table tests for make check: first without the
+	tables, on the fallback and then (if the CPU has it) on AVX2,
+	then with the tables.
+Output:	long - mismatches over all the tests, 0 if everything agrees
+*/
+long run_checks() {
+	long bad = 0;
+	bool avx2 = heuristic_avx2(true);
+
+	heuristic_avx2(false);
+	cout << "Without tables, without AVX2:\n";
+	bad += test_heuristicY_batch();
+	bad += test_heuristicX_batch();
+
+	if (avx2) {
+		heuristic_avx2(true);
+		cout << "Without tables, with AVX2:\n";
+		bad += test_heuristicX_batch();
+	} else {
+		cout << "No AVX2 on this CPU, skipped.\n";
+	}
+
+	cout << "With tables:\n";
+	bad += test_heuristic_tables();
+	bad += test_heuristicY_batch();
+	bad += test_heuristicX_batch();
+	return bad;
+}
+
+
+/* Calls test functions...
+$ ./main_test --check runs run_checks(), and fails if anything mismatched.
+*/
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "--check") {
+		return run_checks() ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
 	test_heuristics();
 	//test_orient(get_state_from_file());
 	//verify_lam(get_state_from_file());
 }
-
-
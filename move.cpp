@@ -28,44 +28,58 @@ Attempts at search functions are included after...
 #include <string>
 #include <vector>
 #include <cmath>
+#include <chrono>
 #include "helper.h"
 #include "heuristic.h"
 #include "move.h"
+#include "profile.h"
 using namespace std;
-
-
-state REMEMBERED, R2;
+using namespace std::chrono;
+
+
+/* Search context constructor */
+SearchContext::SearchContext() {
+	remembered = 0;
+	r2 = 0;
+	tt = NULL;
+	out_of_time = false;
+	nodes = 0;
+	depth = DEPTH;
+	x_beam = BEAM_X;
+	y_beam = BEAM_Y;
+}
 
 
 /* Move function for player X (KR)
 Input:	state s - current state of the board
+		SearchContext& ctx - this game's memory, to avoid repetition
 Output:	returns a char, indicating the best move
 			if char < 64, move K. else move R.
 			char /8 = col, (a-h zero-based)
 			char %8 = row, (1-8 zero-based)
 */
-unsigned char moveX(state s) {
+unsigned char moveX(state s, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
-	vector<unsigned char> moves = list_all_moves_x(s);
+	MoveList moves = list_all_moves_x(s);
 	if (moves.size() == 0) {
 		err("No moves found for X?!?!");
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
-	int rank;
+	RankedMoves ranked_moves;
+	int ranks[MAX_MOVES];
+	heuristicX_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = heuristicX(make_move(s, moves[i], true));
-		ranked_moves.push_back(make_pair(rank, moves[i]));
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
 	}
 	
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
-
-	move = ranked_moves[0].second;
-	if (make_move(s, move, true) == R2) {
-		move = ranked_moves[1].second;
+	move = ranked_moves.pick_best(0).second;
+	if (make_move(s, move, true).key == ctx.r2) {
+		move = ranked_moves.pick_best(1).second;
 	}
-	R2 = REMEMBERED;
-	REMEMBERED = make_move(s, move, true);
+	ctx.r2 = ctx.remembered;
+	ctx.remembered = make_move(s, move, true).key;
 	return move;
 }
 
@@ -77,8 +91,11 @@ Output:	returns a char, indicating the best move
 			char %8 = row, (1-8 zero-based)
 */
 unsigned char moveY(state s) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
-	vector<unsigned char> moves = list_all_moves_y(s);
+	MoveList moves = list_all_moves_y(s);
 	if (moves.size() == 0) {
 		if (DEBUG_VERBOSE) {
 			cout << "No moves found for Y...\n";
@@ -86,50 +103,57 @@ unsigned char moveY(state s) {
 		//TODO: where return to - check for ==255 (mate).
 		return 255;
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
+	RankedMoves ranked_moves;
 	int rank;
+	int ranks[MAX_MOVES];
+	heuristicY_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = heuristicY(make_move(s, moves[i], false));
-		ranked_moves.push_back(make_pair(rank, moves[i]));
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
 	}
 	
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
-
 	if (DEBUG_VERBOSE) {
 		string move_str;
 		unsigned char move;
 		for (int i=0; i < (int)ranked_moves.size(); i++) {
-			rank = ranked_moves[i].first;
+			rank = ranked_moves.pick_best(i).first;
 			move = ranked_moves[i].second;
 			move_str = convert_move_to_PGN(s, move, false);
 			cout << "Move: " << move_str << "  h(n): " << rank << endl;
 		}
 	}
 
-	move = ranked_moves[0].second;
+	move = ranked_moves.pick_best(0).second;
 	return move;
 }
 
 
-/* Same idea as moveX, but has no side-effects */
-unsigned char look_moveX(state s) {
+/* Same idea as moveX, but has no side-effects
+The result only depends on the board, so it is kept in ctx.tt.
+*/
+unsigned char look_moveX(state s, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
-	vector<unsigned char> moves = list_all_moves_x(s);
+	tt_entry* e = ctx.tt ? ctx.tt->probe(s, true, TT_LOOK_X) : NULL;
+	if (e) {
+		return e->move;
+	}
+	MoveList moves = list_all_moves_x(s);
 	if (moves.size() == 0) {
 		err("No moves found for X?!?!");
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
-	int rank;
+	RankedMoves ranked_moves;
+	int ranks[MAX_MOVES];
+	heuristicX_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = heuristicX(make_move(s, moves[i], true));
-		ranked_moves.push_back(make_pair(rank, moves[i]));
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
 	}
 	
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
-
-	move = ranked_moves[0].second;
+	move = ranked_moves.pick_best(0).second;
+	if (ctx.tt) {
+		ctx.tt->store(s, true, TT_LOOK_X, 0, TT_EXACT, ranked_moves[0].first, move);
+	}
 	return move;
 }
 
@@ -141,25 +165,29 @@ Looks at possible moves and replies, and attempts to adjust the heuristic
 The numbers are fudged a little (squaring and rooting...) to attempt to improve
 	the search results.
 */
-unsigned char ex_minimax_moveX(state s, int depth) {
+unsigned char ex_minimax_moveX(state s, int depth, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
 
-	vector<unsigned char> moves = list_all_moves_x(s);
+	MoveList moves = list_all_moves_x(s);
 	if (moves.size() == 0) {
 		err("No moves found for X?!?!");
 	}
-	vector< pair<double, unsigned char> > ranked_moves;
+	FixedList<pair<double, unsigned char>, MAX_MOVES> ranked_moves;
 	double rank;
+	int ranks[MAX_MOVES];
+	heuristicX_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = (double)heuristicX(make_move(s, moves[i], true));
+		rank = (double)ranks[i];
 		if (rank > 1.0) {
 			ranked_moves.push_back(make_pair(rank, moves[i]));
 		}
 	}
 
 	// Keep at most 5 best moves.
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
+	ranked_moves.best_first(5);
 	ranked_moves.resize(5);
 
 	rank = ranked_moves[0].first;
@@ -171,8 +199,8 @@ unsigned char ex_minimax_moveX(state s, int depth) {
 			rank = ranked_moves[i].first;
 			move = ranked_moves[i].second;
 			state s2 = make_move(s, move, true);
-			vector<unsigned char> y_moves = list_all_moves_y(s2);
-			vector< pair<double, state> > y_ranked_states;
+			MoveList y_moves = list_all_moves_y(s2);
+			FixedList<pair<double, state>, MAX_MOVES> y_ranked_states;
 			double rank;
 			//if Y can't respond, X should use this move.
 			if (y_moves.size() == 0) {
@@ -182,16 +210,17 @@ unsigned char ex_minimax_moveX(state s, int depth) {
 				return move;
 			}
 			//find player Y responses [(hY(s3), s3), (_, _), ...]
+			int y_ranks[MAX_MOVES];
+			heuristicY_batch(s2, y_moves, y_ranks);
 			for (int j=0; j < (int)y_moves.size(); j++) {
 				state s3 = make_move(s2, y_moves[j], false);
-				rank = (double)heuristicY(s3);
+				rank = (double)y_ranks[j];
 				if (rank > 1.0) {
 					y_ranked_states.push_back(make_pair(rank, s3));
 				}
 			}
 			//sort them by rank and keep at most 3
-			sort(y_ranked_states.begin(), y_ranked_states.end());
-			reverse(y_ranked_states.begin(), y_ranked_states.end());
+			y_ranked_states.best_first(3);
 			y_ranked_states.resize(3);
 			//get the total heuristic for the moves (to make percents)
 			double total = 0.0;
@@ -218,18 +247,20 @@ unsigned char ex_minimax_moveX(state s, int depth) {
 			double total2 = 0.0;
 			for (int j=0; j < (int)y_ranked_states.size(); j++) {
 				state s3 = y_ranked_states[j].second;
-				unsigned char best_move = ex_minimax_moveX(s3, depth-1);
+				unsigned char best_move = ex_minimax_moveX(s3, depth-1, ctx);
 				int hX_2nd = heuristicX(make_move(s3, best_move, true));
 				total2 += hX_2nd * y_ranked_states[j].first;
 			}
 			ranked_moves[i].first *= sqrt(total2);//try sqrt??
 		}
 		//sort the moves again now that the ranks have changed.
+		//A full sort here: 0/0 above can make a rank NaN, and then the order
+		//(so the move) is wherever std::sort leaves it, which pick_best() would not match.
 		sort(ranked_moves.begin(), ranked_moves.end());
 		reverse(ranked_moves.begin(), ranked_moves.end());
 	}
 
-	if (DEBUG_VERBOSE && depth == DEPTH) {
+	if (DEBUG_VERBOSE && depth == ctx.depth) {
 		string move_str;
 		unsigned char move;
 		for (int i=0; i < (int)ranked_moves.size(); i++) {
@@ -241,12 +272,12 @@ unsigned char ex_minimax_moveX(state s, int depth) {
 	}
 
 	move = ranked_moves[0].second;
-	if (depth == DEPTH) {
-		if (make_move(s, move, true) == R2 && ranked_moves.size() > 1) {
+	if (depth == ctx.depth) {
+		if (make_move(s, move, true).key == ctx.r2 && ranked_moves.size() > 1) {
 			move = ranked_moves[1].second;
 		}
-		R2 = REMEMBERED;
-		REMEMBERED = make_move(s, move, true);
+		ctx.r2 = ctx.remembered;
+		ctx.remembered = make_move(s, move, true).key;
 	}
 	return move;
 }
@@ -256,22 +287,28 @@ unsigned char ex_minimax_moveX(state s, int depth) {
 -Does not do mini, but assumes that opponent will make their best move.
 Assigns the heuristic of future states to possible moves.
 */
-unsigned char minimax_moveY(state s, int depth) {
+unsigned char minimax_moveY(state s, int depth, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
-	vector<unsigned char> moves = list_all_moves_y(s);
+	tt_entry* e = ctx.tt ? ctx.tt->probe(s, false, TT_MINIMAX_Y) : NULL;
+	if (e && e->depth == depth) {
+		return e->move;
+	}
+	MoveList moves = list_all_moves_y(s);
 	if (moves.size() == 0) {
 		return 255;
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
-	int rank;
+	RankedMoves ranked_moves;
+	int ranks[MAX_MOVES];
+	heuristicY_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = heuristicY(make_move(s, moves[i], false));
-		ranked_moves.push_back(make_pair(rank, moves[i]));
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
 	}
 	
 	//sort and keep at most best 4 moves.
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
+	ranked_moves.best_first(4);
 	if (ranked_moves.size() > 4) {
 		ranked_moves.resize(4);
 	}
@@ -284,12 +321,12 @@ unsigned char minimax_moveY(state s, int depth) {
 		for (int i=0; i<(int)ranked_moves.size(); i++) {
 			//s2 is state after our move
 			state s2 = make_move(s, ranked_moves[i].second, false);
-			unsigned char reply = look_moveX(s2);
+			unsigned char reply = look_moveX(s2, ctx);
 			//s3 is state after Xs best reply - skip the minimize step...
 			state s3 = make_move(s2, reply, true);
 			//recurse and decrement depth
 			//mark above move with heuristic of best lower move
-			unsigned char recurse_move = minimax_moveY(s3, depth-1);
+			unsigned char recurse_move = minimax_moveY(s3, depth-1, ctx);
 			if (recurse_move == 255) {
 				val = 0;
 			} else {
@@ -303,6 +340,9 @@ unsigned char minimax_moveY(state s, int depth) {
 	}
 
 	move = ranked_moves[best_move_index].second;
+	if (ctx.tt) {
+		ctx.tt->store(s, false, TT_MINIMAX_Y, depth, TT_EXACT, best_val, move);
+	}
 	return move;
 }
 
@@ -311,22 +351,28 @@ unsigned char minimax_moveY(state s, int depth) {
 Performs maximizing of branches, but adds the heuristic of the best lower
 	branch to the state following possible moves.
 */
-unsigned char additive_minimax_moveY(state s, int depth) {
+unsigned char additive_minimax_moveY(state s, int depth, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
-	vector<unsigned char> moves = list_all_moves_y(s);
+	tt_entry* e = ctx.tt ? ctx.tt->probe(s, false, TT_ADDITIVE_Y) : NULL;
+	if (e && e->depth == depth) {
+		return e->move;
+	}
+	MoveList moves = list_all_moves_y(s);
 	if (moves.size() == 0) {
 		return 255;
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
-	int rank;
+	RankedMoves ranked_moves;
+	int ranks[MAX_MOVES];
+	heuristicY_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		rank = heuristicY(make_move(s, moves[i], false));
-		ranked_moves.push_back(make_pair(rank, moves[i]));
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
 	}
 	
 	//sort and keep at most best 4 moves.
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
+	ranked_moves.best_first(4);
 	if (ranked_moves.size() > 4) {
 		ranked_moves.resize(4);
 	}
@@ -339,12 +385,12 @@ unsigned char additive_minimax_moveY(state s, int depth) {
 		for (int i=0; i<(int)ranked_moves.size(); i++) {
 			//s2 is state after our move
 			state s2 = make_move(s, ranked_moves[i].second, false);
-			unsigned char reply = look_moveX(s2);
+			unsigned char reply = look_moveX(s2, ctx);
 			//s3 is state after Xs best reply - skip the minimize step...
 			state s3 = make_move(s2, reply, true);
 			//recurse and decrement depth
 			//mark above move with heuristic of best lower move
-			unsigned char recurse_move = minimax_moveY(s3, depth-1);
+			unsigned char recurse_move = minimax_moveY(s3, depth-1, ctx);
 			if (recurse_move == 255) {
 				val = 0;
 			} else {
@@ -357,6 +403,9 @@ unsigned char additive_minimax_moveY(state s, int depth) {
 		}
 	}
 	move = ranked_moves[best_move_index].second;
+	if (ctx.tt) {
+		ctx.tt->store(s, false, TT_ADDITIVE_Y, depth, TT_EXACT, best_val, move);
+	}
 	return move;
 }
 
@@ -365,25 +414,29 @@ unsigned char additive_minimax_moveY(state s, int depth) {
 Similar to the above assignment maximizer for Y
 Skips minimization rounds by assuming opponent makes their best move.
 */
-unsigned char maximax_moveX(state s, int depth) {
+unsigned char maximax_moveX(state s, int depth, SearchContext& ctx) {
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
 	unsigned char move = 0;
 
-	vector<unsigned char> moves = list_all_moves_x(s);
+	MoveList moves = list_all_moves_x(s);
 	if (moves.size() == 0) {
 		err("No moves found for X?!?!");
 	}
-	vector< pair<int, unsigned char> > ranked_moves;
+	RankedMoves ranked_moves;
 	int s2_rank;
+	int ranks[MAX_MOVES];
+	heuristicX_batch(s, moves, ranks);
 	for (int i=0; i < (int)moves.size(); i++) {
-		s2_rank = heuristicX(make_move(s, moves[i], true));
+		s2_rank = ranks[i];
 		if (s2_rank > 1) {
 			ranked_moves.push_back(make_pair(s2_rank, moves[i]));
 		}
 	}
 
 	// Keep at most 5 best moves.
-	sort(ranked_moves.begin(), ranked_moves.end());
-	reverse(ranked_moves.begin(), ranked_moves.end());
+	ranked_moves.best_first(5);
 	ranked_moves.resize(5);
 
 	// terminal moves should be greater than 30k
@@ -392,7 +445,7 @@ unsigned char maximax_moveX(state s, int depth) {
 		for (int i=0; i < (int)ranked_moves.size(); i++) {
 			move = ranked_moves[i].second;
 			state s2 = make_move(s, move, true);
-			vector<unsigned char> y_moves = list_all_moves_y(s2);
+			MoveList y_moves = list_all_moves_y(s2);
 			//if Y can't respond, X should use this move.
 			if (y_moves.size() == 0) {
 				if (DEBUG_VERBOSE) {
@@ -414,35 +467,220 @@ unsigned char maximax_moveX(state s, int depth) {
 			}
 
 			//get our best response, add our H val to that.
-			unsigned char best_move = maximax_moveX(s3, depth-1);
+			unsigned char best_move = maximax_moveX(s3, depth-1, ctx);
 			int hX_2nd = heuristicX(make_move(s3, best_move, true));
 
 			ranked_moves[i].first = hX_2nd;
 		}
-		//sort the moves again now that the ranks have changed.
-		sort(ranked_moves.begin(), ranked_moves.end());
-		reverse(ranked_moves.begin(), ranked_moves.end());
+		//the ranks have changed, the moves are picked in the new order below.
 	}
 
-	if (DEBUG_VERBOSE && depth == DEPTH) {
+	if (DEBUG_VERBOSE && depth == ctx.depth) {
 		string move_str;
 		unsigned char move;
 		for (int i=0; i < (int)ranked_moves.size(); i++) {
-			int rank = ranked_moves[i].first;
+			int rank = ranked_moves.pick_best(i).first;
 			move = ranked_moves[i].second;
 			move_str = convert_move_to_PGN(s, move, true);
 			cout << "Move: " << move_str << "  h(n): " << rank << endl;
 		}
 	}
 
-	move = ranked_moves[0].second;
-	if (depth == DEPTH) {
-		if (make_move(s, move, true) == R2 && ranked_moves.size() > 1) {
-			move = ranked_moves[1].second;
+	move = ranked_moves.pick_best(0).second;
+	if (depth == ctx.depth) {
+		if (make_move(s, move, true).key == ctx.r2 && ranked_moves.size() > 1) {
+			move = ranked_moves.pick_best(1).second;
+		}
+		ctx.r2 = ctx.remembered;
+		ctx.remembered = make_move(s, move, true).key;
+	}
+	return move;
+}
+
+
+/* Alpha-beta search for player X
+A real minimax (negamax) search, unlike the ones above: Y is assumed to
+	make the reply that is worst for X, and heuristicX() is only used to
+	score the positions at the bottom of the search.
+Iterative deepening: searches 1 X move ahead, then 2, ... up to
+	MAX_SEARCH_DEPTH, until MOVE_TIME_MS runs out or a mate is found.
+	An unfinished iteration is thrown away, and the best move from the
+	previous one is searched first in the next.
+Input:	state s - current state of the board
+		SearchContext& ctx - this game's memory and the search clock
+Output:	move as in moveX()
+*/
+unsigned char alphabeta_moveX(state s, SearchContext& ctx) {
+	MoveList moves = list_all_moves_x(s);
+	if (moves.size() == 0) {
+		err("No moves found for X?!?!");
+	}
+	ctx.deadline = steady_clock::now() + milliseconds(MOVE_TIME_MS);
+	ctx.out_of_time = false;
+	ctx.nodes = 0;
+
+	//order by heuristic to start with, for better cutoffs.
+	RankedMoves ranked_moves;
+	int ranks[MAX_MOVES];
+	heuristicX_batch(s, moves, ranks);
+	for (int i=0; i < (int)moves.size(); i++) {
+		ranked_moves.push_back(make_pair(ranks[i], moves[i]));
+	}
+	ranked_moves.best_first(ranked_moves.size());
+
+	unsigned char move = ranked_moves[0].second;
+	for (int depth=1; depth <= MAX_SEARCH_DEPTH; depth++) {
+		int alpha = -MATE_SCORE - 1;
+		int best_index = -1;
+		for (int i=0; i < (int)ranked_moves.size(); i++) {
+			state s2 = make_move(s, ranked_moves[i].second, true);
+			if (s2.key == ctx.r2 && ranked_moves.size() > 1) {
+				continue;
+			}
+			//depth is in X moves, each one is two plies.
+			int score = -negamax(s2, false, depth*2 - 2, 1, -MATE_SCORE - 1, -alpha, ctx);
+			if (ctx.out_of_time) {
+				break;
+			}
+			if (score > alpha) {
+				alpha = score;
+				best_index = i;
+			}
+		}
+		if (ctx.out_of_time || best_index < 0) {
+			break;
+		}
+		//search the best move first next time.
+		pair<int, unsigned char> best = ranked_moves[best_index];
+		for (int i=best_index; i > 0; i--) {
+			ranked_moves[i] = ranked_moves[i-1];
+		}
+		ranked_moves[0] = best;
+		move = best.second;
+		if (DEBUG_VERBOSE) {
+			cout << "Depth " << depth << ": " << convert_move_to_PGN(s, move, true)
+				<< "  score: " << alpha << "  nodes: " << ctx.nodes << endl;
+		}
+		if (alpha > MATE_SCORE - 2*MAX_SEARCH_DEPTH) {
+			//forced mate found, deeper won't find a shorter one.
+			break;
 		}
-		R2 = REMEMBERED;
-		REMEMBERED = make_move(s, move, true);
 	}
+
+	ctx.r2 = ctx.remembered;
+	ctx.remembered = make_move(s, move, true).key;
 	return move;
 }
 
+
+/* Negamax with alpha-beta pruning
+Scores are from the point of view of the side to move.
+Mate scores are stored in ctx.tt relative to the node (not the root),
+	so an entry is still right when the board comes up at another ply.
+Input:	state s - board to search
+		bool x_to_move - whose turn it is
+		int depth - plies left to search, runs out on Y's turn
+		int ply - plies from the root, used to prefer shorter mates
+		int alpha, beta - the search window
+		SearchContext& ctx - node count, deadline and table
+Output:	int - score of s, meaningless if ctx.out_of_time was set.
+*/
+int negamax(state s, bool x_to_move, int depth, int ply, int alpha, int beta, SearchContext& ctx) {
+	ctx.nodes++;
+	if (PROFILE_SEARCH) {
+		search_stats.nodes++;
+	}
+	if ((ctx.nodes & 1023) == 0 && steady_clock::now() > ctx.deadline) {
+		ctx.out_of_time = true;
+	}
+	if (ctx.out_of_time) {
+		return 0;
+	}
+
+	MoveList moves;
+	if (x_to_move) {
+		//Y took the rook, draw.
+		if (s.R == 255) {
+			return 0;
+		}
+		moves = list_all_moves_x(s);
+	} else {
+		moves = list_all_moves_y(s);
+		if (moves.size() == 0) {
+			if (y_in_check(s)) {
+				return ply - MATE_SCORE;
+			} else {
+				//stalemate
+				return 0;
+			}
+		}
+		if (depth <= 0) {
+			return -heuristicX(s);
+		}
+	}
+
+	int score;
+	int alpha_orig = alpha;
+	tt_entry* e = ctx.tt ? ctx.tt->probe(s, x_to_move, TT_ALPHABETA) : NULL;
+	if (e) {
+		if (e->depth >= depth) {
+			score = e->score;
+			if (score > MATE_SCORE - 1000) {
+				score -= ply;
+			} else if (score < 1000 - MATE_SCORE) {
+				score += ply;
+			}
+			if (e->bound == TT_EXACT) {
+				return score;
+			} else if (e->bound == TT_LOWER && score > alpha) {
+				alpha = score;
+			} else if (e->bound == TT_UPPER && score < beta) {
+				beta = score;
+			}
+			if (alpha >= beta) {
+				return score;
+			}
+		}
+		//try the stored best move first.
+		for (int i=1; i < (int)moves.size(); i++) {
+			if (moves[i] == e->move) {
+				moves[i] = moves[0];
+				moves[0] = e->move;
+				break;
+			}
+		}
+	}
+
+	int best = -MATE_SCORE - 1;
+	unsigned char best_move = moves[0];
+	for (int i=0; i < (int)moves.size(); i++) {
+		score = -negamax(make_move(s, moves[i], x_to_move), !x_to_move, depth-1, ply+1, -beta, -alpha, ctx);
+		if (score > best) {
+			best = score;
+			best_move = moves[i];
+			if (score > alpha) {
+				alpha = score;
+				if (alpha >= beta) {
+					break;
+				}
+			}
+		}
+	}
+
+	if (ctx.tt && !ctx.out_of_time) {
+		int bound = TT_EXACT;
+		if (best <= alpha_orig) {
+			bound = TT_UPPER;
+		} else if (best >= beta) {
+			bound = TT_LOWER;
+		}
+		score = best;
+		if (score > MATE_SCORE - 1000) {
+			score += ply;
+		} else if (score < 1000 - MATE_SCORE) {
+			score -= ply;
+		}
+		ctx.tt->store(s, x_to_move, TT_ALPHABETA, depth, bound, score, best_move);
+	}
+	return best;
+}
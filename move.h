@@ -1,13 +1,46 @@
 #ifndef MOVE_H
 #define MOVE_H
 
+#include <chrono>
 #include "helper.h"
+#include "transposition.h"
 
-unsigned char moveX(state s);
+#define MATE_SCORE 1000000
+
+/* Per-game search state
+X remembers the keys of the positions its last two moves produced, so it
+	does not shuffle back and forth. Each game gets its own context, which lets
+	games run on separate threads.
+The alpha-beta search also keeps its clock and node count here.
+tt is an optional transposition table shared by the X and Y searches,
+	owned by the caller (NULL for none).
+depth is the depth the engines pass to the fixed-depth searches (DEPTH
+	unless changed), which also use it to recognize their root call.
+x_beam and y_beam are the beam search widths (BEAM_X and BEAM_Y unless
+	changed, see beam.cpp).
+*/
+class SearchContext {
+public:
+	unsigned long long remembered;
+	unsigned long long r2;
+	TransTable* tt;
+	std::chrono::steady_clock::time_point deadline;
+	bool out_of_time;
+	long nodes;
+	int depth;
+	int x_beam;
+	int y_beam;
+	SearchContext();
+};
+
+unsigned char moveX(state s, SearchContext& ctx);
 unsigned char moveY(state s);
-unsigned char ex_minimax_moveX(state s, int depth);
-unsigned char minimax_moveY(state s, int depth);
-unsigned char additive_minimax_moveY(state s, int depth);
-unsigned char maximax_moveX(state s, int depth);
+unsigned char ex_minimax_moveX(state s, int depth, SearchContext& ctx);
+unsigned char look_moveX(state s, SearchContext& ctx);
+unsigned char minimax_moveY(state s, int depth, SearchContext& ctx);
+unsigned char additive_minimax_moveY(state s, int depth, SearchContext& ctx);
+unsigned char maximax_moveX(state s, int depth, SearchContext& ctx);
+unsigned char alphabeta_moveX(state s, SearchContext& ctx);
+int negamax(state s, bool x_to_move, int depth, int ply, int alpha, int beta, SearchContext& ctx);
 
 #endif
\ No newline at end of file
@@ -4,8 +4,8 @@ Author: Phillip Stewart
 play() is used for pitting a user against the AI.
 test_play() runs AI for both players.
 
-Each function calls the move search functions, of which I wrote many.
-	the calls may be swapped out to let the AI use a different search method.
+Each function plays the engines chosen in its EngineConfig (see engine.cpp),
+	so a different search method is just a different command-line flag.
 */
 
 
@@ -16,10 +16,14 @@ Each function calls the move search functions, of which I wrote many.
 #include <iomanip>
 #include <cctype>
 #include <sstream>
+#include <chrono>
 #include "helper.h"
 #include "move.h"
+#include "engine.h"
+#include "profile.h"
 #include "play.h"
 using namespace std;
+using namespace std::chrono;
 
 
 
@@ -29,11 +33,16 @@ Controls the play of the game for player vs computer
 Input:	state s - initial state of the board
 		int max_turns - maximum moves per player allowed.
 		bool x_ai - is AI player x?
+		EngineConfig& cfg - the AI's engine for each side and search depth
 Output:	int - outcome of the game
 */
-void play(state s, int max_turns, bool x_ai) {
+void play(state s, int max_turns, bool x_ai, const EngineConfig& cfg) {
 	int num_turns = 0;
 	unsigned char move;
+	SearchContext ctx;
+	TransTable tt;
+	ctx.tt = &tt;
+	apply_config(ctx, cfg);
 	string x_move_str, y_move_str, response;
 	vector<string> summary;
 	stringstream ss;
@@ -41,7 +50,7 @@ void play(state s, int max_turns, bool x_ai) {
 	while (num_turns < max_turns) {
 		//Player X goes first.
 		if (x_ai) {
-			move = moveX(s);
+			move = cfg.x->fn(s, ctx);
 		} else {
 			move = 255;
 			while (move == 255) {
@@ -64,8 +73,7 @@ void play(state s, int max_turns, bool x_ai) {
 
 		//Player Y's turn:
 		if (!x_ai) {
-			//move = moveY(s);
-			move = additive_minimax_moveY(s, DEPTH);
+			move = cfg.y->fn(s, ctx);
 		} else {
 			if (in_checkmate(s)) {
 				cout << "Checkmate.\n";
@@ -73,6 +81,12 @@ void play(state s, int max_turns, bool x_ai) {
 				ss << ". " << x_move_str << " {Checkmate. Player X wins.}";
 				summary.push_back(ss.str());
 				break;
+			} else if (in_stalemate(s)) {
+				cout << "Stalemate.\n";
+				ss << right << setw(2) << num_turns + 1;
+				ss << ". " << x_move_str << " {Stalemate. Draw.}";
+				summary.push_back(ss.str());
+				break;
 			}
 			move = 255;
 			while (move == 255) {
@@ -86,13 +100,14 @@ void play(state s, int max_turns, bool x_ai) {
 			}
 		}
 		if (move == 255) {
+			ss << right << setw(2) << num_turns + 1;
 			if (in_checkmate(s)) {
 				cout << "Checkmate.\n";
+				ss << ". " << x_move_str << " {Checkmate. Player X wins.}";
 			} else {
 				cout << "Stalemate.\n";
+				ss << ". " << x_move_str << " {Stalemate. Draw.}";
 			}
-			ss << right << setw(2) << num_turns + 1;
-			ss << ". " << x_move_str << " {Checkmate. Player X wins.}";
 			summary.push_back(ss.str());
 			break;
 		}
@@ -135,20 +150,33 @@ void play(state s, int max_turns, bool x_ai) {
 Controls the play of the game. Runs automatically choosing best plays.
 Input:	state s - initial state of the board
 		int max_turns - maximum moves per player allowed.
+		EngineConfig& cfg - the engine for each side and search depth
 */
-void test_play(state s, int max_turns) {
+void test_play(state s, int max_turns, const EngineConfig& cfg) {
 	bool MATE = false;
 	int num_turns = 0;
 	unsigned char move;
+	SearchContext ctx;
+	TransTable tt;
+	ctx.tt = &tt;
+	apply_config(ctx, cfg);
 	string x_move_str, y_move_str;
 	vector<string> summary;
 	stringstream ss;
 	string initial_board = board_string(s);
+	steady_clock::time_point move_start;
+	if (PROFILE_SEARCH) {
+		reset_search_stats();
+	}
 	while (num_turns < max_turns) {
 		//Player X goes first.
-		move = moveX(s);
-		//move = ex_minimax_moveX(s, DEPTH);
-		//move = maximax_moveX(s, DEPTH);
+		if (PROFILE_SEARCH) {
+			move_start = profile_clock();
+		}
+		move = cfg.x->fn(s, ctx);
+		if (PROFILE_SEARCH) {
+			profile_move(move_start, true);
+		}
 		x_move_str = convert_move_to_PGN(s, move, true);
 		s = make_move(s, move, true);
 		if (VERBOSE_RESULTS) {
@@ -156,19 +184,25 @@ void test_play(state s, int max_turns) {
 			print_board(s);
 		}
 
-		//move = moveY(s);
-		//move = minimax_moveY(s, DEPTH);
-		move = additive_minimax_moveY(s, DEPTH);
+		if (PROFILE_SEARCH) {
+			move_start = profile_clock();
+		}
+		move = cfg.y->fn(s, ctx);
+		if (PROFILE_SEARCH) {
+			profile_move(move_start, false);
+		}
 		if (move == 255) {
+			ss << right << setw(2) << num_turns + 1;
 			if (in_checkmate(s)) {
 				cout << "Checkmate.\n";
+				ss << ". " << x_move_str << " {Checkmate. Player X wins.}";
+				MATE = true;
 			} else {
 				cout << "Stalemate.\n";
+				ss << ". " << x_move_str << " {Stalemate. Draw.}";
+				num_turns++;
 			}
-			ss << right << setw(2) << num_turns + 1;
-			ss << ". " << x_move_str << " {Checkmate. Player X wins.}";
 			summary.push_back(ss.str());
-			MATE = true;
 			break;
 		}
 
@@ -208,10 +242,162 @@ void test_play(state s, int max_turns) {
 		}
 	}
 	save_results(initial_board, summary);
+	if (PROFILE_SEARCH) {
+		print_search_stats("Game", search_stats);
+	}
 	return;// num_turns;
 }
 
 
+/* Game controller for the finder and benchmarks
+Like test_play, but prints and saves nothing, just returns the turn count.
+Input:	state s - initial state of the board
+		int max_turns - maximum moves per player allowed.
+		TransTable* tt - the caller's table, kept between games
+		EngineConfig& cfg - the engine for each side and search depth
+		GameRecord* record - if not NULL, filled in with how the game ended
+			and the time each side spent choosing its moves
+Output:	int - number of X moves played
+*/
+int stripped_test_play(state s, int max_turns, TransTable* tt, const EngineConfig& cfg, GameRecord* record) {
+	GAME_OUTCOME result = GAME_UNFINISHED;
+	int num_turns = 0;
+	unsigned char move;
+	SearchContext ctx;
+	ctx.tt = tt;
+	apply_config(ctx, cfg);
+	steady_clock::time_point move_start, move_end;
+	if (record) {
+		record->x_moves = 0;
+		record->y_moves = 0;
+		record->x_secs = 0.0;
+		record->y_secs = 0.0;
+	}
+	while (num_turns < max_turns) {
+		//Player X goes first.
+		if (PROFILE_SEARCH || record) {
+			move_start = steady_clock::now();
+		}
+		move = cfg.x->fn(s, ctx);
+		if (PROFILE_SEARCH) {
+			profile_move(move_start, true);
+		}
+		if (record) {
+			move_end = steady_clock::now();
+			record->x_moves++;
+			record->x_secs += duration<double>(move_end - move_start).count();
+		}
+		s = make_move(s, move, true);
+
+		if (PROFILE_SEARCH || record) {
+			move_start = steady_clock::now();
+		}
+		move = cfg.y->fn(s, ctx);
+		if (PROFILE_SEARCH) {
+			profile_move(move_start, false);
+		}
+		if (record) {
+			move_end = steady_clock::now();
+			record->y_moves++;
+			record->y_secs += duration<double>(move_end - move_start).count();
+		}
+		if (move == 255) {
+			result = in_checkmate(s) ? GAME_MATE : GAME_STALEMATE;
+			num_turns++;
+			break;
+		}
+		s = make_move(s, move, false);
+		if (s.R == 255) {
+			result = GAME_ROOK_TAKEN;
+			break;
+		}
+		num_turns++;
+	}
+	if (record) {
+		record->outcome = result;
+	}
+	return num_turns;
+}
+
+
+/* Batch game evaluation (service mode)
+Reads boards from in, one per line in the test case format, and writes one
+	tab separated line per board to out:
+	<board>	<X's best move>	<result>	<game in PGN>
+	result is the number of X moves to mate, "draw" if Y took the rook,
+	"stalemate", "unfinished" at max_turns, or "invalid" (with no other fields).
+The transposition table is kept for the whole run, so repeated and
+	related boards get faster as the process keeps going.
+Output is flushed whenever the input has nothing more buffered, so a
+	client feeding one board at a time gets each answer right away.
+*/
+void batch_play(istream& in, ostream& out, int max_turns, const EngineConfig& cfg) {
+	TransTable tt;
+	string line;
+	state s;
+	while (getline(in, line)) {
+		if (line.length() == 0) {
+			continue;
+		}
+		if (!parse_state(line, s) || !s.is_valid() || kings_too_close(s) || y_in_check(s)) {
+			out << line << "\tinvalid\n";
+		} else {
+			out << line << "\t" << batch_game(s, max_turns, &tt, cfg) << "\n";
+		}
+		if (in.rdbuf()->in_avail() <= 0) {
+			out.flush();
+		}
+	}
+	out.flush();
+}
+
+
+/* Plays one game for batch_play()
+Output:	string - the best move, result and PGN fields of the result line.
+*/
+string batch_game(state s, int max_turns, TransTable* tt, const EngineConfig& cfg) {
+	SearchContext ctx;
+	ctx.tt = tt;
+	apply_config(ctx, cfg);
+	stringstream pgn;
+	string first_move, result;
+	unsigned char move;
+	int num_turns = 0;
+	result = "unfinished";
+	while (num_turns < max_turns) {
+		move = cfg.x->fn(s, ctx);
+		string x_move_str = convert_move_to_PGN(s, move, true);
+		if (num_turns == 0) {
+			first_move = x_move_str;
+		} else {
+			pgn << " ";
+		}
+		pgn << num_turns + 1 << ". " << x_move_str;
+		s = make_move(s, move, true);
+		num_turns++;
+
+		move = cfg.y->fn(s, ctx);
+		if (move == 255) {
+			if (in_stalemate(s)) {
+				result = "stalemate";
+			} else {
+				stringstream ss;
+				ss << num_turns;
+				result = ss.str();
+			}
+			break;
+		}
+		pgn << " " << convert_move_to_PGN(s, move, false);
+		s = make_move(s, move, false);
+		if (s.R == 255) {
+			result = "draw";
+			break;
+		}
+	}
+	return first_move + "\t" + result + "\t" + pgn.str();
+}
+
+
 void save_results(string initial_board, vector<string> summary) {
 	ofstream ofile;
 	ofile.open("gameResults.txt");
@@ -3,10 +3,28 @@
 
 #include <vector>
 #include <string>
+#include <iostream>
 #include "helper.h"
+#include "transposition.h"
+#include "engine.h"
 
-void play(state s, int max_turns, bool x_ai);
-void test_play(state s, int max_turns);
+/* How a stripped_test_play() game ended */
+enum GAME_OUTCOME {GAME_MATE, GAME_STALEMATE, GAME_ROOK_TAKEN, GAME_UNFINISHED};
+
+/* What stripped_test_play() reports besides the turn count */
+struct GameRecord {
+	GAME_OUTCOME outcome;
+	int x_moves;
+	int y_moves;
+	double x_secs;
+	double y_secs;
+};
+
+void play(state s, int max_turns, bool x_ai, const EngineConfig& cfg);
+void test_play(state s, int max_turns, const EngineConfig& cfg);
+int stripped_test_play(state s, int max_turns, TransTable* tt, const EngineConfig& cfg, GameRecord* record = NULL);
+void batch_play(std::istream& in, std::ostream& out, int max_turns, const EngineConfig& cfg);
+std::string batch_game(state s, int max_turns, TransTable* tt, const EngineConfig& cfg);
 void save_results(std::string initial_board, std::vector<std::string> summary);
 
 #endif
\ No newline at end of file
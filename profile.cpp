@@ -0,0 +1,103 @@
+/* Search instrumentation
+Author: Phillip Stewart
+
+With PROFILE_SEARCH set in helper.h, the searches count what they do:
+	nodes - calls into a search function (each negamax node counts once)
+	heuristic_calls - calls to heuristicX() and heuristicY()
+	move_gens - calls to list_all_moves_x() and list_all_moves_y()
+	and the game loops time every move with profile_clock()/profile_move().
+Every counter sits behind "if (PROFILE_SEARCH)", so with it set to false
+	the compiler drops them and they cost nothing.
+
+The counters are per thread, the finder adds up its workers' counters
+	when they finish. test_play() and run_finder() print the summary.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include "helper.h"
+#include "profile.h"
+using namespace std;
+using namespace std::chrono;
+
+
+thread_local SearchStats search_stats = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+
+
+/* Zeroes this thread's counters. */
+void reset_search_stats() {
+	SearchStats empty = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+	search_stats = empty;
+}
+
+
+/* Adds s into total. */
+void add_search_stats(SearchStats& total, const SearchStats& s) {
+	total.nodes += s.nodes;
+	total.heuristic_calls += s.heuristic_calls;
+	total.move_gens += s.move_gens;
+	total.x_moves += s.x_moves;
+	total.y_moves += s.y_moves;
+	total.x_secs += s.x_secs;
+	total.y_secs += s.y_secs;
+	if (s.max_move_secs > total.max_move_secs) {
+		total.max_move_secs = s.max_move_secs;
+	}
+}
+
+
+/* Start time of a move. */
+steady_clock::time_point profile_clock() {
+	return steady_clock::now();
+}
+
+
+/* Records the time since start as one move for the given player. */
+void profile_move(steady_clock::time_point start, bool player_x) {
+	double secs = duration<double>(steady_clock::now() - start).count();
+	if (player_x) {
+		search_stats.x_moves++;
+		search_stats.x_secs += secs;
+	} else {
+		search_stats.y_moves++;
+		search_stats.y_secs += secs;
+	}
+	if (secs > search_stats.max_move_secs) {
+		search_stats.max_move_secs = secs;
+	}
+}
+
+
+/* Prints the counters, with per move averages. */
+void print_search_stats(string title, const SearchStats& s) {
+	long moves = s.x_moves + s.y_moves;
+	if (moves == 0) {
+		moves = 1;
+	}
+	cout << "--------------------------------------\n";
+	cout << title << " search profile:\n";
+	cout << "Moves:            X " << s.x_moves << ", Y " << s.y_moves << endl;
+	cout << "Nodes:            " << s.nodes << " (" << s.nodes / moves << " per move)\n";
+	cout << "Heuristic calls:  " << s.heuristic_calls << " (" << s.heuristic_calls / moves << " per move)\n";
+	cout << "Move generations: " << s.move_gens << " (" << s.move_gens / moves << " per move)\n";
+	//restored at the end, so later output is not changed.
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	cout << fixed << setprecision(2);
+	if (s.x_moves > 0) {
+		cout << "X time per move:  " << s.x_secs * 1e6 / s.x_moves << " us\n";
+	}
+	if (s.y_moves > 0) {
+		cout << "Y time per move:  " << s.y_secs * 1e6 / s.y_moves << " us\n";
+	}
+	cout << "Slowest move:     " << s.max_move_secs * 1e6 << " us\n";
+	cout << "--------------------------------------\n";
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
+
+// end of profile.cpp
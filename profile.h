@@ -0,0 +1,27 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <string>
+
+/* Counters for the search instrumentation (see profile.cpp) */
+struct SearchStats {
+	long nodes;
+	long heuristic_calls;
+	long move_gens;
+	long x_moves;
+	long y_moves;
+	double x_secs;
+	double y_secs;
+	double max_move_secs;
+};
+
+extern thread_local SearchStats search_stats;
+
+void reset_search_stats();
+void add_search_stats(SearchStats& total, const SearchStats& s);
+std::chrono::steady_clock::time_point profile_clock();
+void profile_move(std::chrono::steady_clock::time_point start, bool player_x);
+void print_search_stats(std::string title, const SearchStats& s);
+
+#endif
@@ -0,0 +1,345 @@
+/* Retrograde tablebase for KR-k
+Author: Phillip Stewart
+
+The whole KR-k state space is only 64^3 boards for each side to move,
+	so instead of estimating with the heuristics we can solve it outright.
+tb_init() builds a distance-to-mate (DTM) table for every legal state:
+	dtm_x[i] - X to move, number of X moves until checkmate.
+	dtm_y[i] - Y to move, number of X moves still needed to mate.
+	TB_DRAW marks draws (rook capture, stalemate) and illegal boards.
+
+The generator works backward from mate one ply at a time:
+	ply 0: every checkmated Y-to-move state.
+	X states are solved at n if some move reaches a Y state solved at n-1.
+	Y states are solved at n if every move reaches an X state solved by n.
+The first ply that adds no X state ends the search, anything left is a draw.
+
+The probe functions then pick the optimal move by looking up each child.
+
+On disk (TB_FILE) only one board out of each set of 8 mirror images is kept.
+	The board is reflected/rotated so that k lands in the triangle a1-d1-d4,
+	leaving 10 k squares * 64 K squares * 64 R squares per side to move.
+	File layout: 8 byte magic, then TB_CANON_SIZE bytes of X-to-move DTM,
+	then TB_CANON_SIZE bytes of Y-to-move DTM, indexed by tb_canonical_index().
+tb_init() maps the file read-only, so every process shares the same pages.
+	If the file is missing it is generated once and written for next time.
+*/
+
+
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "helper.h"
+#include "bitboard.h"
+#include "tablebase.h"
+using namespace std;
+
+
+#define TB_MAGIC "KRKTB01"
+#define TB_HEADER 8
+#define TB_FILE_SIZE (TB_HEADER + 2*TB_CANON_SIZE)
+
+/* Index of each square in the a1-d1-d4 triangle, -1 outside it */
+int KTRI_INDEX[64];
+/* Canonical tables, both point into the mapped file (or tb_memory) */
+const unsigned char* dtm_x = NULL;
+const unsigned char* dtm_y = NULL;
+vector<unsigned char> tb_memory;
+bool tb_ready = false;
+
+
+/* Fills in KTRI_INDEX (SYMMETRY is built at compile time, see bitboard.h) */
+void tb_init_symmetry() {
+	int sq, f, r;
+	int n = 0;
+	for (sq=0; sq < 64; sq++) {
+		f = sq / 8;
+		r = sq % 8;
+		if (f < 4 && r <= f) {
+			KTRI_INDEX[sq] = n++;
+		} else {
+			KTRI_INDEX[sq] = -1;
+		}
+	}
+}
+
+
+/* Packs a state into its table index. R must be on the board. */
+int tb_index(state s) {
+	return (s.K*64 + s.R)*64 + s.k;
+}
+
+
+/* Index into the symmetry-reduced tables
+Finds the first symmetry putting k in the triangle and applies it to K and R.
+*/
+int tb_canonical_index(state s) {
+	for (int t=0; t < 8; t++) {
+		int kt = KTRI_INDEX[SYMMETRY[t][s.k]];
+		if (kt >= 0) {
+			return (kt*64 + SYMMETRY[t][s.K])*64 + SYMMETRY[t][s.R];
+		}
+	}
+	//unreachable, every square has an image in the triangle.
+	return 0;
+}
+
+
+/* Legal boards with X to move: Y may not already be in check. */
+bool legal_x_to_move(state s) {
+	return (s.is_valid() && !kings_too_close(s) && !y_in_check(s));
+}
+
+
+/* Legal boards with Y to move. */
+bool legal_y_to_move(state s) {
+	return (s.is_valid() && !kings_too_close(s));
+}
+
+
+/* Build the full (unreduced) DTM tables by retrograde analysis.
+Input:	full_x, full_y - TB_SIZE bytes each, indexed by tb_index().
+*/
+void tb_generate(unsigned char* full_x, unsigned char* full_y) {
+	unsigned char* dtm_x = full_x;
+	unsigned char* dtm_y = full_y;
+	state s, s2;
+	MoveList moves;
+	int i, j, n;
+
+	//ply 0: checkmates
+	for (i=0; i < TB_SIZE; i++) {
+		dtm_x[i] = TB_DRAW;
+		dtm_y[i] = TB_DRAW;
+		s = state(i/4096, (i/64)%64, i%64);
+		if (legal_y_to_move(s) && in_checkmate(s)) {
+			dtm_y[i] = 0;
+		}
+	}
+
+	bool added = true;
+	for (n=1; added; n++) {
+		//X to move: mate in n if any move reaches a Y state solved at n-1
+		added = false;
+		for (i=0; i < TB_SIZE; i++) {
+			if (dtm_x[i] != TB_DRAW) {
+				continue;
+			}
+			s = state(i/4096, (i/64)%64, i%64);
+			if (!legal_x_to_move(s)) {
+				continue;
+			}
+			moves = list_all_moves_x(s);
+			for (j=0; j < (int)moves.size(); j++) {
+				s2 = make_move(s, moves[j], true);
+				if (dtm_y[tb_index(s2)] == n-1) {
+					dtm_x[i] = n;
+					added = true;
+					break;
+				}
+			}
+		}
+		if (!added) {
+			break;
+		}
+
+		//Y to move: mated in n if every move reaches a solved X state
+		for (i=0; i < TB_SIZE; i++) {
+			if (dtm_y[i] != TB_DRAW) {
+				continue;
+			}
+			s = state(i/4096, (i/64)%64, i%64);
+			if (!legal_y_to_move(s)) {
+				continue;
+			}
+			moves = list_all_moves_y(s);
+			if (moves.size() == 0) {
+				//stalemate
+				continue;
+			}
+			bool solved = true;
+			for (j=0; j < (int)moves.size(); j++) {
+				s2 = make_move(s, moves[j], false);
+				if (s2.R == 255 || dtm_x[tb_index(s2)] == TB_DRAW) {
+					solved = false;
+					break;
+				}
+			}
+			if (solved) {
+				dtm_y[i] = n;
+			}
+		}
+	}
+
+	if (DEBUG_VERBOSE) {
+		cout << "Tablebase built, longest mate: " << n-1 << " moves.\n";
+	}
+}
+
+
+/* Maps a tablebase file into memory.
+Output:	bool - false if the file is missing or not a tablebase.
+*/
+bool tb_load(const char* filename) {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size != TB_FILE_SIZE) {
+		close(fd);
+		return false;
+	}
+	void* map = mmap(NULL, TB_FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+	const unsigned char* data = (const unsigned char*)map;
+	if (memcmp(data, TB_MAGIC, TB_HEADER) != 0) {
+		munmap(map, TB_FILE_SIZE);
+		return false;
+	}
+	dtm_x = data + TB_HEADER;
+	dtm_y = dtm_x + TB_CANON_SIZE;
+	return true;
+}
+
+
+/* Writes the loaded tables to file.
+The file is written under a temporary name and renamed into place,
+	so a process starting at the same time never maps half a file.
+*/
+bool tb_save(const char* filename) {
+	stringstream ss;
+	ss << filename << ".tmp" << getpid();
+	string tmp_name = ss.str();
+	FILE* ofile = fopen(tmp_name.c_str(), "wb");
+	if (ofile == NULL) {
+		return false;
+	}
+	bool good = (fwrite(TB_MAGIC, 1, TB_HEADER, ofile) == TB_HEADER &&
+		fwrite(dtm_x, 1, TB_CANON_SIZE, ofile) == TB_CANON_SIZE &&
+		fwrite(dtm_y, 1, TB_CANON_SIZE, ofile) == TB_CANON_SIZE);
+	good = (fclose(ofile) == 0) && good;
+	if (!good || rename(tmp_name.c_str(), filename) != 0) {
+		remove(tmp_name.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+/* Loads the tablebase, generating TB_FILE first if needed.
+Safe to call more than once, the tables are only loaded the first time.
+*/
+void tb_init() {
+	if (tb_ready) {
+		return;
+	}
+	tb_init_symmetry();
+	if (!tb_load(TB_FILE)) {
+		if (VERBOSE_RESULTS) {
+			cerr << "Generating tablebase " << TB_FILE << "...\n";
+		}
+		vector<unsigned char> full_x(TB_SIZE), full_y(TB_SIZE);
+		tb_generate(&full_x[0], &full_y[0]);
+
+		//keep only the boards with k in the triangle.
+		tb_memory.resize(2*TB_CANON_SIZE);
+		for (int k=0; k < 64; k++) {
+			int kt = KTRI_INDEX[k];
+			if (kt < 0) {
+				continue;
+			}
+			for (int i=0; i < 64*64; i++) {
+				state s(i/64, i%64, k);
+				tb_memory[kt*4096 + i] = full_x[tb_index(s)];
+				tb_memory[TB_CANON_SIZE + kt*4096 + i] = full_y[tb_index(s)];
+			}
+		}
+		dtm_x = &tb_memory[0];
+		dtm_y = dtm_x + TB_CANON_SIZE;
+
+		//prefer the shared mapping if the file could be written.
+		if (tb_save(TB_FILE) && tb_load(TB_FILE)) {
+			vector<unsigned char>().swap(tb_memory);
+		} else if (VERBOSE_RESULTS) {
+			cerr << "Unable to save " << TB_FILE << ", using memory.\n";
+		}
+	}
+	tb_ready = true;
+}
+
+
+/* Distance to mate for a state
+Input:	state s - board to look up
+		bool x_to_move - whose turn it is
+Output:	unsigned char - X moves until mate, or TB_DRAW.
+*/
+unsigned char tb_dtm(state s, bool x_to_move) {
+	tb_init();
+	if (s.R == 255) {
+		return TB_DRAW;
+	}
+	if (x_to_move) {
+		return dtm_x[tb_canonical_index(s)];
+	} else {
+		return dtm_y[tb_canonical_index(s)];
+	}
+}
+
+
+/* Optimal move for player X
+Picks the move leading to the Y state with the shortest mate.
+Output:	move as in moveX()
+*/
+unsigned char tablebase_moveX(state s) {
+	MoveList moves = list_all_moves_x(s);
+	if (moves.size() == 0) {
+		err("No moves found for X?!?!");
+	}
+	unsigned char move = moves[0];
+	unsigned char best = TB_DRAW;
+	unsigned char dtm;
+	for (int i=0; i < (int)moves.size(); i++) {
+		dtm = tb_dtm(make_move(s, moves[i], true), false);
+		if (dtm < best) {
+			best = dtm;
+			move = moves[i];
+		}
+	}
+	return move;
+}
+
+
+/* Optimal move for player Y
+Takes a draw (rook capture) when possible, otherwise delays mate longest.
+Output:	move as in moveY(), 255 if Y has no moves.
+*/
+unsigned char tablebase_moveY(state s) {
+	MoveList moves = list_all_moves_y(s);
+	if (moves.size() == 0) {
+		return 255;
+	}
+	unsigned char move = moves[0];
+	int best = -1;
+	int dtm;
+	for (int i=0; i < (int)moves.size(); i++) {
+		dtm = tb_dtm(make_move(s, moves[i], false), true);
+		if (dtm > best) {
+			best = dtm;
+			move = moves[i];
+		}
+	}
+	return move;
+}
+
+
+// end of tablebase.cpp
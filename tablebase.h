@@ -0,0 +1,21 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "helper.h"
+
+#define TB_FILE "krk.tb"
+#define TB_SIZE (64*64*64)
+#define TB_CANON_SIZE (10*64*64)
+#define TB_DRAW 255
+
+void tb_init();
+bool tb_load(const char* filename);
+bool tb_save(const char* filename);
+void tb_generate(unsigned char* full_x, unsigned char* full_y);
+int tb_index(state s);
+int tb_canonical_index(state s);
+unsigned char tb_dtm(state s, bool x_to_move);
+unsigned char tablebase_moveX(state s);
+unsigned char tablebase_moveY(state s);
+
+#endif
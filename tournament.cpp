@@ -0,0 +1,219 @@
+/* Engine-vs-engine tournament
+Author: Phillip Stewart
+
+Plays every X engine against every Y engine (see engine.cpp) from every
+	legal starting board, X to move, and reports for each pairing:
+	mate rate, mean/median/p99 X moves to mate, rook captures, stalemates,
+	games still going after TOURNAMENT_TURNS, and time per move per side.
+With step > 1 only every step-th board is played, which keeps the slow
+	engines (alpha-beta spends MOVE_TIME_MS on every move) practical.
+
+Each pairing is played by a pool of worker threads, one per core.
+	Workers claim TOURNAMENT_CHUNK boards at a time from a shared counter,
+	keep their own totals and transposition table, and the totals are added
+	up once they are done. Mate lengths are kept as a histogram, so the
+	median and p99 come out without storing every game.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "helper.h"
+#include "engine.h"
+#include "play.h"
+#include "transposition.h"
+#include "tournament.h"
+using namespace std;
+using namespace std::chrono;
+
+
+void match_worker(atomic<int>* next_chunk, const vector<state>* boards,
+	const EngineConfig* cfg, MatchResult* result);
+void add_match_result(MatchResult& total, const MatchResult& r);
+int mate_percentile(const MatchResult& r, double p);
+
+
+/* Every legal board with X to move, or every step-th one. */
+vector<state> tournament_boards(int step) {
+	vector<state> boards;
+	state s;
+	int n = 0;
+	for (int i=0; i < 64*64*64; i++) {
+		s = state(i / (64*64), (i / 64) % 64, i % 64);
+		if (!s.is_valid() || kings_too_close(s) || y_in_check(s)) {
+			continue;
+		}
+		if (n++ % step == 0) {
+			boards.push_back(s);
+		}
+	}
+	return boards;
+}
+
+
+/* Plays cfg.x against cfg.y from each board
+Output:	MatchResult - totals over all the games.
+*/
+MatchResult run_match(const EngineConfig& cfg, const vector<state>& boards) {
+	atomic<int> next_chunk(0);
+	int num_threads = thread::hardware_concurrency();
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	vector<MatchResult> results(num_threads);
+	vector<thread> workers;
+	for (int t=0; t < num_threads; t++) {
+		workers.push_back(thread(match_worker, &next_chunk, &boards, &cfg, &results[t]));
+	}
+	MatchResult total = MatchResult();
+	total.x = cfg.x;
+	total.y = cfg.y;
+	for (int t=0; t < num_threads; t++) {
+		workers[t].join();
+		add_match_result(total, results[t]);
+	}
+	return total;
+}
+
+
+/* Worker thread for run_match
+Input:	next_chunk - shared counter of the next TOURNAMENT_CHUNK boards to play
+		boards - the starting boards
+		cfg - the engines to play
+		result - filled with this worker's totals when done
+*/
+void match_worker(atomic<int>* next_chunk, const vector<state>* boards,
+	const EngineConfig* cfg, MatchResult* result) {
+	MatchResult r = MatchResult();
+	TransTable tt;
+	GameRecord record;
+	int chunk, turns;
+	while ((chunk = (*next_chunk)++) * TOURNAMENT_CHUNK < (int)boards->size()) {
+		int end = (chunk + 1) * TOURNAMENT_CHUNK;
+		if (end > (int)boards->size()) {
+			end = boards->size();
+		}
+		for (int i=chunk * TOURNAMENT_CHUNK; i < end; i++) {
+			turns = stripped_test_play((*boards)[i], TOURNAMENT_TURNS, &tt, *cfg, &record);
+			r.games++;
+			if (record.outcome == GAME_MATE) {
+				r.mates++;
+				r.mate_turns[turns]++;
+			} else if (record.outcome == GAME_ROOK_TAKEN) {
+				r.rook_taken++;
+			} else if (record.outcome == GAME_STALEMATE) {
+				r.stalemates++;
+			} else {
+				r.unfinished++;
+			}
+			r.x_moves += record.x_moves;
+			r.y_moves += record.y_moves;
+			r.x_secs += record.x_secs;
+			r.y_secs += record.y_secs;
+		}
+	}
+	*result = r;
+}
+
+
+/* Adds r into total, except for the engine names. */
+void add_match_result(MatchResult& total, const MatchResult& r) {
+	total.games += r.games;
+	total.mates += r.mates;
+	total.rook_taken += r.rook_taken;
+	total.stalemates += r.stalemates;
+	total.unfinished += r.unfinished;
+	for (int i=0; i <= TOURNAMENT_TURNS; i++) {
+		total.mate_turns[i] += r.mate_turns[i];
+	}
+	total.x_moves += r.x_moves;
+	total.y_moves += r.y_moves;
+	total.x_secs += r.x_secs;
+	total.y_secs += r.y_secs;
+}
+
+
+/* Smallest mate length that at least fraction p of the mates reach. */
+int mate_percentile(const MatchResult& r, double p) {
+	long seen = 0;
+	for (int i=0; i <= TOURNAMENT_TURNS; i++) {
+		seen += r.mate_turns[i];
+		if (seen > 0 && seen >= p * r.mates) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+
+/* Plays every pairing of the given engines and prints the table
+Input:	x_engines, y_engines - the engines for each side
+		base - search depth and beam widths (its engines are not used)
+		step - play every step-th legal board
+*/
+void run_tournament(vector<const Engine*> x_engines, vector<const Engine*> y_engines,
+	const EngineConfig& base, int step) {
+	vector<state> boards = tournament_boards(step);
+	cout << "Tournament: " << boards.size() << " boards, depth " << base.depth
+		<< ", beam " << base.x_beam << "," << base.y_beam
+		<< ", max " << TOURNAMENT_TURNS << " turns.\n";
+	vector<MatchResult> results;
+	EngineConfig cfg = base;
+	for (int i=0; i < (int)x_engines.size(); i++) {
+		for (int j=0; j < (int)y_engines.size(); j++) {
+			cfg.x = x_engines[i];
+			cfg.y = y_engines[j];
+			steady_clock::time_point start = steady_clock::now();
+			results.push_back(run_match(cfg, boards));
+			cerr << cfg.x->name << " vs " << cfg.y->name << ": "
+				<< duration<double>(steady_clock::now() - start).count() << " s\n";
+		}
+	}
+	print_match_results(results);
+}
+
+
+/* Prints one line per pairing
+Mate lengths are in X moves, times are microseconds per move.
+*/
+void print_match_results(const vector<MatchResult>& results) {
+	cout << left << setw(12) << "X" << setw(12) << "Y" << right
+		<< setw(8) << "games" << setw(8) << "mate%" << setw(7) << "mean"
+		<< setw(7) << "median" << setw(5) << "p99" << setw(8) << "rook"
+		<< setw(8) << "stale" << setw(8) << "unfin"
+		<< setw(10) << "X us/mv" << setw(10) << "Y us/mv" << endl;
+	//restored at the end, so later output is not changed.
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	cout << fixed;
+	for (int i=0; i < (int)results.size(); i++) {
+		const MatchResult& r = results[i];
+		double mean = 0.0;
+		for (int t=0; t <= TOURNAMENT_TURNS; t++) {
+			mean += (double)t * r.mate_turns[t];
+		}
+		if (r.mates > 0) {
+			mean /= r.mates;
+		}
+		cout << left << setw(12) << r.x->name << setw(12) << r.y->name << right
+			<< setw(8) << r.games
+			<< setw(8) << setprecision(2) << (r.games ? 100.0 * r.mates / r.games : 0.0)
+			<< setw(7) << setprecision(2) << mean
+			<< setw(7) << mate_percentile(r, 0.5)
+			<< setw(5) << mate_percentile(r, 0.99)
+			<< setw(8) << r.rook_taken << setw(8) << r.stalemates << setw(8) << r.unfinished
+			<< setw(10) << setprecision(2) << (r.x_moves ? r.x_secs * 1e6 / r.x_moves : 0.0)
+			<< setw(10) << setprecision(2) << (r.y_moves ? r.y_secs * 1e6 / r.y_moves : 0.0)
+			<< endl;
+	}
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
+
+// end of tournament.cpp
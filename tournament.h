@@ -0,0 +1,33 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <vector>
+#include "helper.h"
+#include "engine.h"
+
+#define TOURNAMENT_TURNS 35
+#define TOURNAMENT_CHUNK 256
+
+/* Totals for one X engine against one Y engine */
+struct MatchResult {
+	const Engine* x;
+	const Engine* y;
+	long games;
+	long mates;
+	long rook_taken;
+	long stalemates;
+	long unfinished;
+	long mate_turns[TOURNAMENT_TURNS + 1];
+	long x_moves;
+	long y_moves;
+	double x_secs;
+	double y_secs;
+};
+
+std::vector<state> tournament_boards(int step);
+MatchResult run_match(const EngineConfig& cfg, const std::vector<state>& boards);
+void run_tournament(std::vector<const Engine*> x_engines, std::vector<const Engine*> y_engines,
+	const EngineConfig& base, int step);
+void print_match_results(const std::vector<MatchResult>& results);
+
+#endif
@@ -0,0 +1,78 @@
+/* Transposition table for the search functions
+Author: Phillip Stewart
+
+A KR-k board packs into 18 bits (3 squares of 6 bits), plus one bit for
+	the side to move, so the table simply has one entry for every board.
+	No hashing, and no collisions between different boards.
+
+Each entry remembers which search stored it (TT_SEARCH), since the X and
+	Y search functions share one table but mean different things by a
+	score or a best move. An entry from another search counts as a miss.
+	TT_ALPHABETA - negamax score and bound, best move.
+	TT_LOOK_X - look_moveX() result.
+	TT_MINIMAX_Y, TT_ADDITIVE_Y - result of the Y search at that depth.
+
+The table is about 4MB, so it is made once per game or worker thread and
+	handed to the searches through SearchContext.
+*/
+
+
+#include <vector>
+#include "helper.h"
+#include "transposition.h"
+using namespace std;
+
+
+/* Table constructor, starts empty. */
+TransTable::TransTable() {
+	entries.resize(TT_SIZE);
+	clear();
+}
+
+
+/* Index of a board: side to move, then K, R, k as 6 bits each. */
+int tt_index(state s, bool x_to_move) {
+	return (x_to_move ? 64*64*64 : 0) + (s.K*64 + s.R)*64 + s.k;
+}
+
+
+/* Looks up a board
+Output:	tt_entry* - the entry, or NULL if this search has not stored it.
+*/
+tt_entry* TransTable::probe(state s, bool x_to_move, int search) {
+	if (s.R == 255) {
+		return NULL;
+	}
+	tt_entry* e = &entries[tt_index(s, x_to_move)];
+	if (e->bound == TT_EMPTY || e->search != search) {
+		return NULL;
+	}
+	return e;
+}
+
+
+/* Stores a search result, replacing whatever was there. */
+void TransTable::store(state s, bool x_to_move, int search, int depth, int bound,
+	int score, unsigned char move) {
+	if (s.R == 255) {
+		return;
+	}
+	tt_entry* e = &entries[tt_index(s, x_to_move)];
+	e->score = score;
+	e->depth = (unsigned char)(depth < 0 ? 0 : depth);
+	e->bound = bound;
+	e->move = move;
+	e->search = search;
+}
+
+
+/* Empties the table. */
+void TransTable::clear() {
+	tt_entry empty = {0, 0, TT_EMPTY, 0, 0};
+	for (int i=0; i < TT_SIZE; i++) {
+		entries[i] = empty;
+	}
+}
+
+
+// end of transposition.cpp
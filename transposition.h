@@ -0,0 +1,33 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <vector>
+#include "helper.h"
+
+#define TT_SIZE (2*64*64*64)
+
+enum TT_BOUND {TT_EMPTY=0, TT_EXACT, TT_LOWER, TT_UPPER};
+enum TT_SEARCH {TT_ALPHABETA=0, TT_LOOK_X, TT_MINIMAX_Y, TT_ADDITIVE_Y};
+
+struct tt_entry {
+	int score;
+	unsigned char depth;
+	unsigned char bound;
+	unsigned char move;
+	unsigned char search;
+};
+
+class TransTable {
+public:
+	TransTable();
+	tt_entry* probe(state s, bool x_to_move, int search);
+	void store(state s, bool x_to_move, int search, int depth, int bound,
+		int score, unsigned char move);
+	void clear();
+private:
+	std::vector<tt_entry> entries;
+};
+
+int tt_index(state s, bool x_to_move);
+
+#endif